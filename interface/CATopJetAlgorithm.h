@@ -29,6 +29,9 @@
 #include "DataFormats/Math/interface/deltaR.h"
 #include "RecoJets/JetAlgorithms/interface/JetAlgoHelper.h"
 #include "RecoJets/JetAlgorithms/interface/CompoundPseudoJet.h"
+#include "RecoJets/JetAlgorithms/interface/JetSplittingRecord.h"
+#include "RecoJets/JetAlgorithms/interface/JetAreaConfig.h"
+#include "RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h"
 #include "DataFormats/Candidate/interface/LeafCandidate.h"
 #include "FWCore/Framework/interface/Event.h"
 
@@ -78,12 +81,45 @@ class CATopJetAlgorithm{
 
       { }
 
+    /// Select the area mode of cluster() (see JetAreaConfig); default is no area.
+    void setAreaConfig( const JetAreaConfig & areaConfig ) { areaConfig_ = areaConfig; }
+    const JetAreaConfig & areaConfig() const { return areaConfig_; }
+
+    /// Cluster the inputs for run(): algorithm_ with the R of the event's
+    /// sumEt bin, and the configured area mode, through cache if given.
+    /// Returns a null sequence if the event is below the lowest sumEt bin.
+    boost::shared_ptr<fastjet::ClusterSequence> cluster( const std::vector<fastjet::PseudoJet> & cell_particles,
+							 ClusterSequenceCache * cache = 0
+							 ) const;
+
     /// Find the ProtoJets from the collection of input Candidates.
+    /// fjClusterSeq is clustered by the caller, possibly shared with other
+    /// algorithms through a ClusterSequenceCache.
     void run( const std::vector<fastjet::PseudoJet> & cell_particles, 
 	      std::vector<fastjet::PseudoJet> & hardjetsOutput ,
 	      boost::shared_ptr<fastjet::ClusterSequence> & fjClusterSeq
 	      );
 
+    /// Momentum-scale (JES) variations: rerun the tagger decisions as if all
+    /// inputs had been scaled by each of scales. A uniform scale leaves the
+    /// rapidity/phi of every input, and therefore the clustering history at
+    /// a given R, unchanged; the absolute pt cuts (ptMin, sumEt bins,
+    /// modified adjacency) are reevaluated, and the output 4-vectors are
+    /// scaled. fjClusterSeq, from cluster(), is reused for every scale which
+    /// leaves the event at the same R; a scale moving the event to a sumEt
+    /// bin with another R is reclustered (through cache if given).
+    /// hardjetsOutput[i] corresponds to scales[i], and refers to
+    /// fjClusterSeqs[i] (null if the scaled event is below the lowest bin).
+    /// The constituents of the scaled subjets still refer to the unscaled
+    /// inputs.
+    void runScaleVariations( const std::vector<fastjet::PseudoJet> & cell_particles,
+			     const boost::shared_ptr<fastjet::ClusterSequence> & fjClusterSeq,
+			     const std::vector<double> & scales,
+			     std::vector<std::vector<fastjet::PseudoJet> > & hardjetsOutput,
+			     std::vector<boost::shared_ptr<fastjet::ClusterSequence> > & fjClusterSeqs,
+			     ClusterSequenceCache * cache = 0
+			     ) const;
+
  private:
 
   edm::InputTag       mSrc_;          			//<! calo tower input source
@@ -107,6 +143,24 @@ class CATopJetAlgorithm{
   double              sumEtEtaCut_;   			//<! eta for event SumEt - NOT USED                                 
   double              etFrac_;	      			//<! fraction of event sumEt / 2 for a jet to be considered "hard" - NOT USED 
   std::string         jetType_;       			//<! CaloJets or GenJets - NOT USED
+  JetAreaConfig       areaConfig_;                  //<! area mode of cluster()
+
+
+  // Cluster the inputs with the R of sumEt bin sumEtBinId
+  boost::shared_ptr<fastjet::ClusterSequence> cluster(const std::vector<fastjet::PseudoJet> & cell_particles,
+						      int sumEtBinId,
+						      ClusterSequenceCache * cache) const;
+
+
+  // Index of the sumEt bin of the inputs, momenta scaled by scale; -1 if below the lowest bin
+  int sumEtBin(const std::vector<fastjet::PseudoJet> & cell_particles, double scale) const;
+
+
+  // Find the top jets in an existing cluster sequence, momenta scaled by scale
+  void findTopJets(const std::vector<fastjet::PseudoJet> & cell_particles,
+		   const fastjet::ClusterSequence & fjClusterSeq,
+		   double scale,
+		   std::vector<fastjet::PseudoJet> & hardjetsOutput) const;
 
 
   // Decide if the two jets are in adjacent cells    
@@ -118,11 +172,12 @@ class CATopJetAlgorithm{
 
   // Attempt to break up one "hard" jet into two "soft" jets
 
-  bool decomposeJet(const fastjet::PseudoJet & theJet, 
-		    const fastjet::ClusterSequence & theClusterSequence, 
+  bool decomposeJet(const JetSplittingRecord & theRecord, 
+		    int theJet, 
 		    const std::vector<fastjet::PseudoJet> & cell_particles,
+		    double scale,
 		    double ptHard, double nCellMin, double deltarcut,
-		    fastjet::PseudoJet & ja, fastjet::PseudoJet & jb, 
+		    int & ja, int & jb, 
 		    std::vector<fastjet::PseudoJet> & leftovers) const;
 
 };
@@ -0,0 +1,145 @@
+#ifndef RecoJets_JetAlgorithms_ClusterSequenceCache_h
+#define RecoJets_JetAlgorithms_ClusterSequenceCache_h 1
+
+
+/*
+  ClusterSequenceCache
+  --------------------
+
+  Event-scoped store of fastjet::ClusterSequences, so that several jet
+  algorithms running on the same inputs with the same jet (and area)
+  definition in one event share a single clustering.
+
+  Sequences are identified by
+    - the input collection: address and size of the input vector, plus a
+      fingerprint of its momenta and user indices which guards against a
+      different collection reusing the same storage within the event,
+    - the jet definition, by its description() (which includes the plugin
+      description for plugin-based definitions),
+    - the area definition, by its description() (no area if none is given),
+      or the GhostTemplatePool template used for the clustering.
+
+  So a sequence is only shared by algorithms whose jet and area definitions
+  coincide exactly. In this package:
+    - CATopJetAlgorithm and SubjetFilterAlgorithm share when their plain
+      jet algorithm, R and JetAreaConfig agree;
+    - SubJetAlgorithm and GroomingEngine cluster with FastPrunePlugin
+      definitions, whose description includes the pruning parameters (zcut,
+      Rcut_factor, unpruned minpT and pruning mode): they only share with
+      instances using the same plugin parameters, never with the
+      plain-definition algorithms;
+    - with a GhostTemplatePool the template is chosen from the inputs
+      (GhostTemplatePool::select()), i.e. once per event and input
+      collection, so the algorithms using the same pool share it.
+
+  The ghosted area clusterings (all but Voronoi areas) draw their ghosts
+  from fastjet's process-global random generator, which is not
+  thread-safe: cluster(), and through it get(), serializes them with
+  ghostRandomMutex(). Code in this package which uses that generator in
+  any other way (e.g. GhostTemplatePool) takes the same mutex.
+
+  The cache is not thread-safe: use one instance per event stream and call
+  clear() at the beginning of every event. The jet definition, and for
+  plugin-based definitions the plugin, must stay valid as long as the
+  returned sequences are used, as for any ClusterSequence.
+
+*/
+
+
+#include "RecoJets/JetAlgorithms/interface/GhostTemplatePool.h"
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/AreaDefinition.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include "tbb/mutex.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+class ClusterSequenceCache
+{
+  //
+  // types
+  //
+public:
+  typedef boost::shared_ptr<fastjet::ClusterSequence> ClusterSequencePtr;
+
+
+  //
+  // construction / destruction
+  //
+public:
+  ClusterSequenceCache();
+  ~ClusterSequenceCache();
+
+
+  //
+  // member functions
+  //
+public:
+  /// sequence for inputs clustered with jetDef (and areaDef, if not null);
+  /// clustered on the first request in the event, shared afterwards
+  ClusterSequencePtr get(const std::vector<fastjet::PseudoJet>& inputs,
+			 const fastjet::JetDefinition&          jetDef,
+			 const fastjet::AreaDefinition*         areaDef=0);
+
+  /// same, with explicit-ghost active areas from the pool's template for
+  /// the inputs (see GhostTemplatePool::select())
+  ClusterSequencePtr get(const std::vector<fastjet::PseudoJet>& inputs,
+			 const fastjet::JetDefinition&          jetDef,
+			 const GhostTemplatePool&               ghosts);
+
+  /// drop all sequences at the end of the event; statistics are kept
+  void clear();
+
+  /// cluster without caching, ClusterSequenceArea if areaDef is not null;
+  /// ghosted areas are clustered under ghostRandomMutex()
+  static ClusterSequencePtr cluster(const std::vector<fastjet::PseudoJet>& inputs,
+				    const fastjet::JetDefinition&          jetDef,
+				    const fastjet::AreaDefinition*         areaDef=0);
+
+  /// guards fastjet's global ghost random generator
+  static tbb::mutex& ghostRandomMutex();
+
+  unsigned    size()    const { return sequences_.size(); }
+  unsigned    nHits()   const { return nHits_; }
+  unsigned    nMisses() const { return nMisses_; }
+  unsigned    nEvents() const { return nEvents_; }
+  std::string summary() const;
+
+private:
+  struct Key {
+    const fastjet::PseudoJet* inputs;
+    size_t                    nInputs;
+    size_t                    fingerprint;
+    std::string               jetDef;
+    std::string               areaDef;
+    bool operator<(const Key& other) const;
+  };
+
+  static Key    key(const std::vector<fastjet::PseudoJet>& inputs,
+		     const fastjet::JetDefinition&          jetDef,
+		     const std::string&                     areaDef);
+  static size_t fingerprint(const std::vector<fastjet::PseudoJet>& inputs);
+
+
+  //
+  // member data
+  //
+private:
+  std::map<Key,ClusterSequencePtr> sequences_;
+  unsigned                         nHits_;
+  unsigned                         nMisses_;
+  unsigned                         nEvents_;
+  bool                             used_;
+
+};
+
+
+#endif
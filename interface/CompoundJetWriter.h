@@ -0,0 +1,98 @@
+#ifndef RecoJets_JetAlgorithms_CompoundJetWriter_h
+#define RecoJets_JetAlgorithms_CompoundJetWriter_h 1
+
+
+/*
+  CompoundJetWriter
+  -----------------
+
+  Conversion of CompoundPseudoJet output (CompoundPseudoJetCollection or
+  std::vector<CompoundPseudoJet>) into the reco::BasicJet collections
+  written by the compound jet producers:
+
+    - the subjets, whose constituents are the input candidates, and
+    - the fat jets, whose constituents are edm::Ptrs to the subjets.
+
+  Since the fat jets refer to the subjets, the subjets have to be put into
+  the event first: fillSubJets(), put, fillFatJets() with the returned
+  OrphanHandle, or put() which does all of it. All outputs are reserved up
+  front and the constituent lists are filled directly from the stored
+  input indices.
+
+  The inputs are the candidates the PseudoJets were made of, indexed by the
+  PseudoJets' user_index.
+
+*/
+
+
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJet.h"
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
+
+#include "DataFormats/JetReco/interface/BasicJet.h"
+#include "DataFormats/JetReco/interface/BasicJetCollection.h"
+#include "DataFormats/Candidate/interface/Candidate.h"
+#include "DataFormats/Common/interface/OrphanHandle.h"
+#include "FWCore/Framework/interface/Event.h"
+
+#include <string>
+#include <vector>
+
+
+class CompoundJetWriter
+{
+  //
+  // construction / destruction
+  //
+public:
+  explicit CompoundJetWriter(const std::string& subJetInstanceName);
+  ~CompoundJetWriter();
+
+
+  //
+  // member functions
+  //
+public:
+  /// append the subjets of all fat jets, in order
+  void fillSubJets(const CompoundPseudoJetCollection&     jets,
+		   const std::vector<reco::CandidatePtr>& inputs,
+		   reco::BasicJetCollection&              subJets) const;
+  void fillSubJets(const std::vector<CompoundPseudoJet>&  jets,
+		   const std::vector<reco::CandidatePtr>& inputs,
+		   reco::BasicJetCollection&              subJets) const;
+
+  /// append the fat jets; subJetHandle refers to the subjets filled by
+  /// fillSubJets(), starting at index subJetOffset of the put collection
+  void fillFatJets(const CompoundPseudoJetCollection&                   jets,
+		   const edm::OrphanHandle<reco::BasicJetCollection>&   subJetHandle,
+		   reco::BasicJetCollection&                            fatJets,
+		   unsigned                                             subJetOffset=0) const;
+  void fillFatJets(const std::vector<CompoundPseudoJet>&                jets,
+		   const edm::OrphanHandle<reco::BasicJetCollection>&   subJetHandle,
+		   reco::BasicJetCollection&                            fatJets,
+		   unsigned                                             subJetOffset=0) const;
+
+  /// fill and put subjets (with the subjet instance name) and fat jets
+  void put(edm::Event&                            iEvent,
+	   const CompoundPseudoJetCollection&     jets,
+	   const std::vector<reco::CandidatePtr>& inputs) const;
+  void put(edm::Event&                            iEvent,
+	   const std::vector<CompoundPseudoJet>&  jets,
+	   const std::vector<reco::CandidatePtr>& inputs) const;
+
+  const std::string& subJetInstanceName() const { return subJetInstanceName_; }
+
+private:
+  static reco::BasicJet makeJet(double px,double py,double pz,double e,double area,
+				const reco::Jet::Constituents& constituents);
+
+
+  //
+  // member data
+  //
+private:
+  std::string subJetInstanceName_;
+
+};
+
+
+#endif
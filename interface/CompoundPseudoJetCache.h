@@ -0,0 +1,208 @@
+#ifndef RecoJets_JetAlgorithms_CompoundPseudoJetCache_h
+#define RecoJets_JetAlgorithms_CompoundPseudoJetCache_h 1
+
+
+/*
+  CompoundPseudoJetCache
+  ----------------------
+
+  Compact binary file format for CompoundPseudoJet collections, so that a
+  selection can be rerun on stored substructure results without running
+  SubJetAlgorithm/SubjetFilterAlgorithm again.
+
+  CompoundPseudoJetCacheWriter appends one record per event,
+  CompoundPseudoJetCacheReader maps the file into memory and gives
+  zero-copy views of the events.
+
+  File layout (version 1, native byte order, every field 4-byte aligned):
+
+    FileHeader     magic "CPJC", version, byte order mark, reserved
+    per event:
+      RecordHeader   record size in bytes (including the header), run,
+                     lumi, event (two words), nJets, nSubJets, nBytes
+      PackedP4       fat jets [nJets]
+      uint32         first subjet of each fat jet [nJets+1]
+      PackedP4       subjets [nSubJets]
+      uint32         first constituent byte of each subjet [nSubJets+1]
+      uint8          constituent indices as LEB128 varints [nBytes],
+                     padded to a multiple of 4 bytes
+
+  4-vectors and areas are stored as floats (relative precision ~1e-7).
+  The reader throws cms::Exception for files with a wrong magic, version
+  or byte order, and for truncated or inconsistent records: every offset
+  table must start at 0, be non-decreasing and end at its array's size.
+  Overlong or unterminated varints throw when the subjet is decoded.
+
+*/
+
+
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJet.h"
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+namespace CompoundPseudoJetCache
+{
+  const uint32_t kMagic     = 0x434a5043; // "CPJC"
+  const uint32_t kVersion   = 1;
+  const uint32_t kByteOrder = 0x01020304;
+
+  struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t reserved;
+  };
+
+  struct RecordHeader {
+    uint32_t size;
+    uint32_t run;
+    uint32_t lumi;
+    uint32_t eventLow;
+    uint32_t eventHigh;
+    uint32_t nJets;
+    uint32_t nSubJets;
+    uint32_t nBytes;
+  };
+
+  struct PackedP4 {
+    float px;
+    float py;
+    float pz;
+    float e;
+    float area;
+  };
+}
+
+
+class CompoundPseudoJetCacheWriter
+{
+  //
+  // construction / destruction
+  //
+public:
+  explicit CompoundPseudoJetCacheWriter(const std::string& fileName);
+  ~CompoundPseudoJetCacheWriter();
+
+
+  //
+  // member functions
+  //
+public:
+  void write(uint32_t run,uint32_t lumi,uint64_t event,
+	     const CompoundPseudoJetCollection& jets);
+  void write(uint32_t run,uint32_t lumi,uint64_t event,
+	     const std::vector<CompoundPseudoJet>& jets);
+  void close();
+
+  unsigned nEvents() const { return nEvents_; }
+
+private:
+  CompoundPseudoJetCacheWriter(const CompoundPseudoJetCacheWriter&);
+  CompoundPseudoJetCacheWriter& operator=(const CompoundPseudoJetCacheWriter&);
+
+  void putP4(double px,double py,double pz,double e,double area);
+  void putWord(uint32_t word);
+  void putVarint(uint32_t value);
+  void flush(uint32_t run,uint32_t lumi,uint64_t event,
+	     uint32_t nJets,uint32_t nSubJets);
+
+
+  //
+  // member data
+  //
+private:
+  std::string                                  fileName_;
+  std::FILE*                                   file_;
+  unsigned                                     nEvents_;
+  std::vector<CompoundPseudoJetCache::PackedP4> jets_;
+  std::vector<uint32_t>                        subJetBegins_;
+  std::vector<CompoundPseudoJetCache::PackedP4> subJets_;
+  std::vector<uint32_t>                        byteBegins_;
+  std::vector<uint8_t>                         bytes_;
+  std::vector<char>                            record_;
+
+};
+
+
+class CompoundPseudoJetCacheReader
+{
+  //
+  // types
+  //
+public:
+  /// zero-copy view of one event, valid as long as the reader
+  class EventView {
+  public:
+    EventView() : header_(0),jets_(0),subJetBegins_(0),subJets_(0),byteBegins_(0),bytes_(0) {}
+
+    uint32_t run()   const { return header_->run; }
+    uint32_t lumi()  const { return header_->lumi; }
+    uint64_t event() const;
+
+    unsigned size()                     const { return header_->nJets; }
+    const CompoundPseudoJetCache::PackedP4& hardJet(unsigned i) const { return jets_[i]; }
+    unsigned subJetBegin(unsigned i)    const { return subJetBegins_[i]; }
+    unsigned subJetEnd(unsigned i)      const { return subJetBegins_[i+1]; }
+    unsigned nSubJets()                 const { return header_->nSubJets; }
+    const CompoundPseudoJetCache::PackedP4& subJet(unsigned j)  const { return subJets_[j]; }
+
+    /// decode the constituent indices of subjet j
+    void constituents(unsigned j,std::vector<int>& indices) const;
+
+    /// append all jets to a collection / a vector of CompoundPseudoJets
+    void fill(CompoundPseudoJetCollection& jets) const;
+    void fill(std::vector<CompoundPseudoJet>& jets) const;
+
+  private:
+    friend class CompoundPseudoJetCacheReader;
+    const CompoundPseudoJetCache::RecordHeader* header_;
+    const CompoundPseudoJetCache::PackedP4*     jets_;
+    const uint32_t*                             subJetBegins_;
+    const CompoundPseudoJetCache::PackedP4*     subJets_;
+    const uint32_t*                             byteBegins_;
+    const uint8_t*                              bytes_;
+  };
+
+
+  //
+  // construction / destruction
+  //
+public:
+  explicit CompoundPseudoJetCacheReader(const std::string& fileName);
+  ~CompoundPseudoJetCacheReader();
+
+
+  //
+  // member functions
+  //
+public:
+  unsigned  size()                const { return records_.size(); }
+  EventView event(unsigned i)     const;
+
+private:
+  CompoundPseudoJetCacheReader(const CompoundPseudoJetCacheReader&);
+  CompoundPseudoJetCacheReader& operator=(const CompoundPseudoJetCacheReader&);
+
+  void index();
+  static bool validOffsets(const uint32_t* begins,uint32_t n,uint32_t total);
+
+
+  //
+  // member data
+  //
+private:
+  std::string            fileName_;
+  int                    fd_;
+  const char*            data_;
+  size_t                 size_;
+  std::vector<EventView> records_;
+
+};
+
+
+#endif
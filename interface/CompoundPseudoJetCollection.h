@@ -0,0 +1,269 @@
+#ifndef RecoJets_JetAlgorithms_CompoundPseudoJetCollection_h
+#define RecoJets_JetAlgorithms_CompoundPseudoJetCollection_h 1
+
+
+/*
+  CompoundPseudoJetCollection
+  ---------------------------
+
+  All fat jets, subjets and subjet constituent indices of one event in
+  three contiguous arrays, with offset tables (CSR layout): fat jet i owns
+  subjets [subJetBegin(i),subJetEnd(i)), subjet j owns constituents
+  [constituentBegin(j),constituentEnd(j)). Subjets are indexed globally.
+
+  The collection is filled jet by jet: addJet() starts a fat jet,
+  addSubJet() starts a subjet of the last fat jet and addConstituent()
+  appends to the last subjet. clear() keeps the allocated storage, so a
+  collection reused from event to event stops allocating once it has
+  reached the size of a busy event.
+
+  The contents are the same as those of a std::vector<CompoundPseudoJet>,
+  see toCompoundPseudoJets().
+
+  Every jet is also stored as a plain FourVector (px,py,pz,E,area). With
+  FourVectors storage, only these are kept: the PseudoJets, which through
+  their structure keep the whole ClusterSequence (and its ghosts) alive,
+  are dropped, so the sequence can be freed as soon as the algorithm
+  returns. hardJet()/subJet() then throw, and toCompoundPseudoJets()
+  returns PseudoJets without cluster sequence.
+
+  Optionally (setOwnerIndex()), the collection also keeps a dense reverse
+  index from constituent index (the input user_index) to the owning fat
+  jet and (global) subjet, filled by addConstituent(), so that owner()
+  lookups are O(1). If a constituent is added to several subjets, the
+  first one wins: for SubjetFilterAlgorithm, whose filter jets overlap the
+  two mass-drop subjets, particles are owned by the mass-drop subjets.
+
+  Jet areas can be computed on demand: after setAreaSequence(), jets added
+  with addJetLazyArea()/addSubJetLazyArea() only remember their position in
+  the clustering history, and the area is computed on the first access
+  (hardJetArea(), hardJetP4(), ..., or the conversion to CompoundPseudoJets).
+  The area sequence is cast to ClusterSequenceAreaBase once, and kept alive
+  until clear(). Since that would defeat FourVectors storage,
+  setAreaSequence() throws for it: those collections get their areas
+  when the jets are added. The first access is not thread-safe.
+
+*/
+
+
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJet.h"
+
+#include <fastjet/PseudoJet.hh>
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/ClusterSequenceAreaBase.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+
+class CompoundPseudoJetCollection
+{
+  //
+  // types
+  //
+public:
+  struct FourVector {
+    double px;
+    double py;
+    double pz;
+    double e;
+    double area;
+  };
+
+  enum Storage { PseudoJets, FourVectors };
+
+  struct Owner {
+    int jet;      // fat jet index, -1 if not a constituent
+    int subJet;   // global subjet index, -1 if not a constituent
+  };
+
+
+  //
+  // construction / destruction
+  //
+public:
+  explicit CompoundPseudoJetCollection(Storage storage=PseudoJets)
+    : storage_(storage), ownerIndex_(false), areaSeq_(0) {}
+  ~CompoundPseudoJetCollection() {}
+
+
+  //
+  // member functions
+  //
+public:
+  Storage storage() const { return storage_; }
+  /// change the storage mode, removes all jets
+  void setStorage(Storage storage) { clear(); storage_ = storage; }
+
+  /// enable/disable the constituent -> owner index, removes all jets
+  void setOwnerIndex(bool ownerIndex) { clear(); ownerIndex_ = ownerIndex; }
+  bool hasOwnerIndex() const { return ownerIndex_; }
+  /// make the owner index cover constituent indices [0,n), e.g. all inputs
+  void resizeOwnerIndex(unsigned n);
+
+  /// sequence from which lazy areas are computed (until clear())
+  void setAreaSequence(const boost::shared_ptr<fastjet::ClusterSequence>& cs);
+  bool hasAreaSequence() const { return 0!=areaSeq_; }
+  const fastjet::ClusterSequence* areaSequence() const { return areaSeqOwner_.get(); }
+
+  /// remove all jets, keeping the allocated storage
+  void clear();
+  void reserve(unsigned nJets,unsigned nSubJets,unsigned nConstituents);
+
+  /// fill interface
+  void addJet(const fastjet::PseudoJet& hardJet,double hardJetArea=0.0);
+  void addSubJet(const fastjet::PseudoJet& subJet,double subJetArea=0.0);
+  /// same, the area is computed from the area sequence on first access
+  void addJetLazyArea(const fastjet::PseudoJet& hardJet);
+  void addSubJetLazyArea(const fastjet::PseudoJet& subJet);
+  void addConstituent(int index);
+  void addConstituents(const std::vector<int>& indices);
+  /// remove the last subjet (of the last fat jet) and its constituents
+  void popSubJet();
+
+  /// fat jets
+  unsigned                  size()                   const { return hardJetP4s_.size(); }
+  bool                      empty()                  const { return hardJetP4s_.empty(); }
+  const fastjet::PseudoJet& hardJet(unsigned i)      const;
+  const FourVector&         hardJetP4(unsigned i)    const;
+  double                    hardJetArea(unsigned i)  const { return hardJetP4(i).area; }
+  unsigned                  subJetBegin(unsigned i)  const { return subJetBegins_[i]; }
+  unsigned                  subJetEnd(unsigned i)    const;
+  unsigned                  nSubJets(unsigned i)     const { return subJetEnd(i)-subJetBegin(i); }
+
+  /// subjets, by global index
+  unsigned                  nSubJets()                    const { return subJetP4s_.size(); }
+  const fastjet::PseudoJet& subJet(unsigned j)            const;
+  const FourVector&         subJetP4(unsigned j)          const;
+  double                    subJetArea(unsigned j)        const { return subJetP4(j).area; }
+  unsigned                  constituentBegin(unsigned j)  const { return constituentBegins_[j]; }
+  unsigned                  constituentEnd(unsigned j)    const;
+  unsigned                  nConstituents(unsigned j)     const { return constituentEnd(j)-constituentBegin(j); }
+
+  /// constituent indices, by global index
+  unsigned                  nConstituents()               const { return constituents_.size(); }
+  int                       constituent(unsigned k)       const { return constituents_[k]; }
+  const int*                constituents(unsigned j)      const;
+
+  /// owning fat jet and subjet of constituent index, {-1,-1} if none
+  const Owner&              owner(int index)              const;
+  unsigned                  nOwners()                     const { return owners_.size(); }
+
+  /// append the jets, as CompoundPseudoJets
+  void toCompoundPseudoJets(std::vector<CompoundPseudoJet>& jets) const;
+  CompoundPseudoJet compoundPseudoJet(unsigned i) const;
+
+private:
+  static FourVector fourVector(const fastjet::PseudoJet& jet,double area);
+  static fastjet::PseudoJet pseudoJet(const FourVector& p4);
+  static const Owner& unowned();
+  static void throwNoPseudoJets();
+  double area(int histIndex) const;
+
+
+  //
+  // member data
+  //
+private:
+  Storage                         storage_;
+  std::vector<fastjet::PseudoJet> hardJets_;    // empty for FourVectors storage
+  mutable std::vector<FourVector> hardJetP4s_;
+  mutable std::vector<int>        hardJetAreaHist_; // history index of pending area, else -1
+  std::vector<unsigned>           subJetBegins_;
+  std::vector<fastjet::PseudoJet> subJets_;     // empty for FourVectors storage
+  mutable std::vector<FourVector> subJetP4s_;
+  mutable std::vector<int>        subJetAreaHist_;  // history index of pending area, else -1
+  std::vector<unsigned>           constituentBegins_;
+  std::vector<int>                constituents_;
+  bool                            ownerIndex_;
+  std::vector<Owner>              owners_;      // by constituent index
+  boost::shared_ptr<fastjet::ClusterSequence> areaSeqOwner_;
+  const fastjet::ClusterSequenceAreaBase*     areaSeq_;
+
+};
+
+
+//______________________________________________________________________________
+inline void CompoundPseudoJetCollection::addConstituent(int index)
+{
+  constituents_.push_back(index);
+  if (!ownerIndex_||index<0) return;
+  if ((unsigned)index>=owners_.size()) resizeOwnerIndex(index+1);
+  Owner& owner = owners_[index];
+  if (owner.subJet>=0) return;
+  owner.jet    = hardJetP4s_.size()-1;
+  owner.subJet = subJetP4s_.size()-1;
+}
+
+
+//______________________________________________________________________________
+inline const CompoundPseudoJetCollection::Owner&
+CompoundPseudoJetCollection::owner(int index) const
+{
+  return (index>=0&&(unsigned)index<owners_.size()) ? owners_[index] : unowned();
+}
+
+
+//______________________________________________________________________________
+inline const fastjet::PseudoJet& CompoundPseudoJetCollection::hardJet(unsigned i) const
+{
+  if (storage_!=PseudoJets) throwNoPseudoJets();
+  return hardJets_[i];
+}
+
+
+//______________________________________________________________________________
+inline const fastjet::PseudoJet& CompoundPseudoJetCollection::subJet(unsigned j) const
+{
+  if (storage_!=PseudoJets) throwNoPseudoJets();
+  return subJets_[j];
+}
+
+
+//______________________________________________________________________________
+inline const CompoundPseudoJetCollection::FourVector&
+CompoundPseudoJetCollection::hardJetP4(unsigned i) const
+{
+  if (hardJetAreaHist_[i]>=0) {
+    hardJetP4s_[i].area = area(hardJetAreaHist_[i]);
+    hardJetAreaHist_[i] = -1;
+  }
+  return hardJetP4s_[i];
+}
+
+
+//______________________________________________________________________________
+inline const CompoundPseudoJetCollection::FourVector&
+CompoundPseudoJetCollection::subJetP4(unsigned j) const
+{
+  if (subJetAreaHist_[j]>=0) {
+    subJetP4s_[j].area = area(subJetAreaHist_[j]);
+    subJetAreaHist_[j] = -1;
+  }
+  return subJetP4s_[j];
+}
+
+
+//______________________________________________________________________________
+inline unsigned CompoundPseudoJetCollection::subJetEnd(unsigned i) const
+{
+  return (i+1<subJetBegins_.size()) ? subJetBegins_[i+1] : subJetP4s_.size();
+}
+
+
+//______________________________________________________________________________
+inline unsigned CompoundPseudoJetCollection::constituentEnd(unsigned j) const
+{
+  return (j+1<constituentBegins_.size()) ? constituentBegins_[j+1] : constituents_.size();
+}
+
+
+//______________________________________________________________________________
+inline const int* CompoundPseudoJetCollection::constituents(unsigned j) const
+{
+  return constituents_.empty() ? 0 : &constituents_[0]+constituentBegin(j);
+}
+
+
+#endif
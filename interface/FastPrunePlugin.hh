@@ -22,10 +22,8 @@
 //      ClusterSequence holding pruned versions of all the original jets.
 // 4) Pruned away branches are marked in the history as entries that are not
 //      not subsequently recombined (i.e., child == Invalid).  This means that
-//      only inclusive_jets(ptcut) makes sense.  Future versions of this plugin
-//      will hopefully include an Extras() object with the ClusterSequence so
-//      that the pruned branches can be associated with the points they were
-//      pruned from.
+//      only inclusive_jets(ptcut) makes sense.  The Extras (see below) list
+//      the pruned branches of each jet by their history index.
 //
 // An external Recombiner can be passed to the constructor: the
 //   PrunedRecombiner will only determine whether to prune a recombination; the
@@ -37,6 +35,23 @@
 //   zcut and Rcut; the user can create their own derived class to set these
 //   on a jet-by-jet basis.
 //
+// The ClusterSequence also gets a FastPrunePlugin::Extras object, which
+//   holds the unpruned ClusterSequence and, for each input particle, the
+//   unpruned jet it belongs to, so that pruned jets can be matched to the
+//   jets they were pruned from without clustering the event again.  The
+//   pruned away branches of each jet are kept there as well, as history
+//   indices in the pruned sequence, so reading them copies nothing.
+//
+// The plugin is not changed by run_clustering(): everything that belongs to
+//   one clustering (the unpruned sequence, the PrunedRecombiner with the
+//   cuts of the current jet, the pruned branches) is either local to
+//   run_clustering() or goes into the Extras.  One JetDefinition with this
+//   plugin can therefore be used by several threads at the same time,
+//   provided the CutSetter implements the const get_cuts() (as
+//   DefaultCutSetter does); setters that only implement SetCuts(),
+//   including classes derived from DefaultCutSetter, are called under a
+//   lock.
+//
 ///////////////////////////////////////////////////////////////////////////////
 
 #ifndef __FASTPRUNEPLUGIN_HH__
@@ -46,8 +61,11 @@
 
 #include "fastjet/ClusterSequence.hh"
 #include "fastjet/JetDefinition.hh"
+#include "fastjet/SharedPtr.hh"
 
 #include <string>
+#include <memory>
+#include <typeinfo>
 
 FASTJET_BEGIN_NAMESPACE      // defined in fastjet/internal/base.hh
 
@@ -56,6 +74,7 @@ class FastPrunePlugin : public JetDefinition::Plugin {
 public:
 
 	class CutSetter;
+	class Extras;
 
 	/// Constructors for the FastPrunePlugin, whose arguments have the
 	/// following meaning:
@@ -109,22 +128,59 @@ public:
 	                 CutSetter* const cut_setter,
 	                 const JetDefinition::Recombiner* recomb);
 
-	
-	// Get the set of pruned away PseudoJets (valid in pruned ClusterSequence)
-	// Each vector corresponds to one of the unpruned jets, in pT order
-	virtual std::vector<std::vector<PseudoJet> > pruned_subjets() const {return _pruned_subjets;}
 
 	// The things that are required by base class.
 	virtual std::string description () const;
 	virtual void run_clustering(ClusterSequence &) const;
 
+	/// Pruning scan: prunes particles once for each of cut_setters, finding
+	///  the unpruned jets and their constituents only once.  pruned_jets[k]
+	///  are the pruned jets (pT > ptmin, by decreasing pT) for
+	///  cut_setters[k], from a ClusterSequence of their own with Extras as
+	///  in run_clustering(); it is deleted with the last of its jets.
+	void run_scan(const std::vector<PseudoJet> & particles,
+	              const std::vector<const CutSetter*> & cut_setters,
+	              std::vector<std::vector<PseudoJet> > & pruned_jets,
+	              double ptmin = 0.0) const;
+
 	// Sets minimum pT for unpruned jets (default is 20 GeV)
 	//  (Just to save time by not pruning jets we don't care about)
 	virtual void set_unpruned_minpT(double pt) {_minpT = pt;}
+
+	// Prune the unpruned jets of an event concurrently (with TBB), each
+	//  with its own PrunedRecombiner; the mergings are still recorded in
+	//  pT order, so the result is the same as in the serial mode (default).
+	//  The CutSetter must be reentrant (see get_cuts()) to profit.
+	virtual void set_parallel_pruning(bool parallel) {_parallel_pruning = parallel;}
+	virtual bool parallel_pruning() const {return _parallel_pruning;}
+
+	// Fast mode for Cambridge/Aachen find and prune definitions (throws
+	//  otherwise): apply the pruning test while walking the unpruned C/A
+	//  history of each jet bottom-up, instead of reclustering its
+	//  constituents, which saves one ClusterSequence per jet.  The test is
+	//  applied to the same pruned momenta, and for C/A the reclustering
+	//  usually repeats the unpruned mergings, so the results agree for
+	//  nearly all jets.  They can differ when
+	//   - a pruned merging moves the pruned jet (which keeps the direction
+	//     of its harder parent) enough to change the order of the later
+	//     C/A mergings in the reclustering; the walk keeps the unpruned
+	//     order,
+	//   - pieces of a large-R jet end up farther apart than the prune
+	//     definition's R (pi/2), so that the reclustering leaves them as
+	//     separate jets; the walk always gives one pruned jet per jet,
+	//   - the find and prune definitions use different recombination
+	//     schemes; the walk uses the tree of the former with the
+	//     recombiner of the latter.
+	//  The parallel mode is not used with history pruning.
+	virtual void set_history_pruning(bool history);
+	virtual bool history_pruning() const {return _history_pruning;}
 	
 	// Access to parameters.
 	virtual double R() const {return _find_definition.R();}
 	virtual double zcut() const {return _cut_setter->zcut;}
+	// deprecated: Rcut of the last jet passed to the CutSetter's SetCuts().
+	//  The reentrant DefaultCutSetter::get_cuts() does not store it, so
+	//  with the default setter this is the value given to the constructor.
 	virtual double Rcut() const {return _cut_setter->Rcut;}
 	// only meaningful for DefaultCutSetter:
 	virtual double Rcut_factor() const {
@@ -133,34 +189,62 @@ public:
 		else return -1.0;
 	}
 
-	// ***** DEPRECATED **** -- use FastPruneTool instead; this will be removed
-	//  in a future release!
-	// Access to unpruned cluster sequence that gets made along the way
-	//  This should only be used after run_clustering() has been called,
-	//  i.e., after the plugin has been used to find jets.  I've added
-	//  this for speed, so you don't have to duplicate the effort of
-	//  finding unpruned jets.
-	virtual ClusterSequence *get_unpruned_sequence() const {return _unpruned_seq;}
-
-	virtual ~FastPrunePlugin() {delete _unpruned_seq; delete _pruned_recombiner;
-                              delete _cut_setter;}
+	virtual ~FastPrunePlugin() {delete _pruned_recombiner; delete _cut_setter;}
 
 protected:
 
 	JetDefinition _find_definition;
-	mutable JetDefinition _prune_definition; // mutable: we change its Recombiner*
+	// run_clustering() uses a copy of it with its own PrunedRecombiner
+	JetDefinition _prune_definition;
 	double _minpT; // minimum pT for unpruned jets
+	bool _parallel_pruning; // prune the jets of an event concurrently
+	bool _history_pruning; // C/A: prune by walking the unpruned history
 
-	mutable std::vector<std::vector<PseudoJet> > _pruned_subjets;
-	mutable ClusterSequence* _unpruned_seq;
-	
-	mutable PrunedRecombiner* _pruned_recombiner;
+	// prototype of the PrunedRecombiner, copied by each run_clustering()
+	PrunedRecombiner* _pruned_recombiner;
 	
+	// unpruned jets of an event and their constituents, shared by all
+	//  prunings of the event
+	struct _Unpruned {
+		SharedPtr<ClusterSequence> seq;
+		std::vector<PseudoJet> jets;
+		std::vector<int> jet_of_input;
+		std::vector<int> jet_of_hist; // -1 for elements of no jet
+		std::vector<std::vector<PseudoJet> > constituents;
+		std::vector<std::vector<int> > constituent_indices; // in input_seq
+	};
+	class _ScanPlugin;
+	friend class _ScanPlugin;
+
+	void _find_unpruned(const std::vector<PseudoJet> & particles,
+	                    _Unpruned & unpruned) const;
+
+	// prunes the unpruned jets into input_seq, returns its Extras
+	std::auto_ptr<Extras> _prune(const _Unpruned & unpruned,
+	                             const CutSetter & cut_setter,
+	                             ClusterSequence & input_seq) const;
+
+	// prunes the unpruned jets by walking their C/A history, recording the
+	//  pruned jets directly in out_seq (see set_history_pruning())
+	void _prune_history(const _Unpruned & unpruned,
+	                    const CutSetter & cut_setter,
+	                    ClusterSequence & out_seq,
+	                    std::vector<int> & pruned_branches,
+	                    std::vector<unsigned> & pruned_branch_begins) const;
+
 	// Takes the merging structure of "in_seq" and feeds this into
-	//  "out_seq" using _plugin_record_{ij,iB}_recombination()
-	void _output_mergings(ClusterSequence & in_seq,
-	                      std::vector<int> & pruned_pseudojets,
-	                      ClusterSequence & out_seq) const;
+	//  "out_seq" using _plugin_record_{ij,iB}_recombination(), particle k
+	//  of in_seq being particle input_indices[k] of out_seq; the history
+	//  indices in out_seq of the branches pruned away are appended to
+	//  pruned_branches
+	//  (is_pruned and out_index are work buffers reused across jets)
+	void _output_mergings(const ClusterSequence & in_seq,
+	                      const std::vector<int> & pruned_pseudojets,
+	                      const std::vector<int> & input_indices,
+	                      std::vector<char> & is_pruned,
+	                      std::vector<int> & out_index,
+	                      ClusterSequence & out_seq,
+	                      std::vector<int> & pruned_branches) const;
 
 	// this class stores info on how to dynamically set zcut and Rcut
 	//  const because we won't change it
@@ -176,9 +260,91 @@ public:
 		double zcut, Rcut;
 		virtual void SetCuts(const PseudoJet &jet,
 		                     const ClusterSequence &clust_seq) = 0;
+		// cuts for jet without changing the setter, used by
+		//  run_clustering(); override it to make the setter reentrant.  The
+		//  default calls SetCuts() under a lock shared by all setters.
+		virtual void get_cuts(const PseudoJet &jet,
+		                      const ClusterSequence &clust_seq,
+		                      double &z, double &R) const;
 		virtual ~CutSetter() {}
 	};
 
+	/// Extras of a ClusterSequence made with this plugin: the unpruned
+	///   sequence and jets (in pT order, pT > unpruned_minpT), and the
+	///   unpruned jet of each input particle, which is the unpruned jet of
+	///   every pruned jet containing that particle.  The unpruned sequence
+	///   is made from the particles as given (user_index's included), so
+	///   other algorithms can use it as well.
+	///
+	/// The branches pruned away from unpruned jet i are the history
+	///   elements [pruned_branches_begin(i), pruned_branches_end(i)) of the
+	///   pruned sequence (all branches of an event in one array, with an
+	///   offset table), in the order in which they were pruned.  They never
+	///   merge again; pruned_branch() gives the PseudoJet of one without
+	///   copying it.
+	class Extras : public ClusterSequence::Extras {
+	public:
+		typedef std::vector<int>::const_iterator branch_iterator;
+
+		Extras(const SharedPtr<ClusterSequence> & unpruned_seq,
+		       const std::vector<PseudoJet> & unpruned_jets,
+		       const std::vector<int> & unpruned_jet_of_input,
+		       const std::vector<int> & pruned_branches,
+		       const std::vector<unsigned> & pruned_branch_begins)
+			: _unpruned_seq(unpruned_seq), _unpruned_jets(unpruned_jets),
+			  _unpruned_jet_of_input(unpruned_jet_of_input),
+			  _pruned_branches(pruned_branches),
+			  _pruned_branch_begins(pruned_branch_begins) {}
+		const ClusterSequence & unpruned_sequence() const {return *_unpruned_seq;}
+		const std::vector<PseudoJet> & unpruned_jets() const {return _unpruned_jets;}
+		// index in unpruned_jets() of the jet containing input particle i
+		//   (history index i in the pruned sequence), -1 if none
+		int unpruned_jet_index(int i) const {
+			return (i >= 0 && i < int(_unpruned_jet_of_input.size())) ?
+				_unpruned_jet_of_input[i] : -1;
+		}
+		// index in unpruned_jets() of a jet of the pruned sequence cs, -1
+		//   if it does not come from one (follows parent1 down to a particle)
+		int unpruned_jet_index(const ClusterSequence & cs,
+		                       const PseudoJet & jet) const {
+			const std::vector<ClusterSequence::history_element> & hist =
+				cs.history();
+			int h = jet.cluster_hist_index();
+			if (h < 0 || h >= int(hist.size())) return -1;
+			while (hist[h].parent1 >= 0) h = hist[h].parent1;
+			return unpruned_jet_index(h);
+		}
+		// pruned branches of unpruned jet i, as history indices in the
+		//   pruned sequence
+		branch_iterator pruned_branches_begin(unsigned i) const {
+			return _pruned_branches.begin() + _pruned_branch_begins[i];
+		}
+		branch_iterator pruned_branches_end(unsigned i) const {
+			return _pruned_branches.begin() + _pruned_branch_begins[i+1];
+		}
+		unsigned n_pruned_branches(unsigned i) const {
+			return _pruned_branch_begins[i+1] - _pruned_branch_begins[i];
+		}
+		// the PseudoJet of the pruned branch with history index h in the
+		//   pruned sequence cs
+		static const PseudoJet & pruned_branch(const ClusterSequence & cs,
+		                                       int h) {
+			return cs.jets()[cs.history()[h].jetp_index];
+		}
+		virtual std::string description() const {
+			return "FastPrunePlugin: unpruned jets of the pruned jets";
+		}
+	private:
+		SharedPtr<ClusterSequence> _unpruned_seq;
+		std::vector<PseudoJet> _unpruned_jets;
+		std::vector<int> _unpruned_jet_of_input;
+		std::vector<int> _pruned_branches;
+		std::vector<unsigned> _pruned_branch_begins; // unpruned_jets()+1 entries
+		// plugin of a run_scan() sequence, which must live as long as it
+		SharedPtr<JetDefinition::Plugin> _scan_plugin;
+		friend class FastPrunePlugin::_ScanPlugin;
+	};
+
 	/// Default CutSetter implementation: never changes zcut,
 	///   and Rcut = Rcut_factor * 2m/pT for a given jet
 	class DefaultCutSetter : public CutSetter {
@@ -188,11 +354,28 @@ public:
 		double Rcut_factor;
 		virtual void SetCuts(const PseudoJet &jet,
 		                     const ClusterSequence &clust_seq) {
+			default_cuts(jet, clust_seq, zcut, Rcut);
+		}
+		// reentrant only for DefaultCutSetter itself: a derived setter may
+		//  override SetCuts() alone, so it goes through the base get_cuts()
+		virtual void get_cuts(const PseudoJet &jet,
+		                      const ClusterSequence &clust_seq,
+		                      double &z, double &R) const {
+			if (typeid(*this) == typeid(DefaultCutSetter))
+				default_cuts(jet, clust_seq, z, R);
+			else
+				CutSetter::get_cuts(jet, clust_seq, z, R);
+		}
+	protected:
+		void default_cuts(const PseudoJet &jet,
+		                  const ClusterSequence &clust_seq,
+		                  double &z, double &R) const {
 			PseudoJet p1, p2;
+			z = zcut;
 			if (! clust_seq.has_parents(jet, p1, p2))
-				Rcut = 0.0;
+				R = 0.0;
 			else
-				Rcut = Rcut_factor*2.0*jet.m()/jet.perp();
+				R = Rcut_factor*2.0*jet.m()/jet.perp();
 		}
 	};
 
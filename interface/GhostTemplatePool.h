@@ -0,0 +1,93 @@
+#ifndef RecoJets_JetAlgorithms_GhostTemplatePool_h
+#define RecoJets_JetAlgorithms_GhostTemplatePool_h 1
+
+
+/*
+  GhostTemplatePool
+  -----------------
+
+  Precomputed ghost sets for active area clustering with explicit ghosts.
+  The ghost positions and momenta only depend on the GhostedAreaSpec and
+  the random numbers, not on the event, so instead of generating tens of
+  thousands of ghosts for every clustering (as
+  ClusterSequenceActiveAreaExplicitGhosts does), a small pool of templates
+  is generated once and copied into each clustering.
+
+  The pool only replaces explicit-ghost clustering, which uses a single
+  ghost set per clustering and keeps the ghosts in the history. It is not
+  a substitute for the ghost-free active areas of ClusterSequenceActiveArea
+  (which removes the ghosts from the history and averages over the spec's
+  repeats), and must not be used where the algorithm walks a history that
+  is ghost-free otherwise.
+
+  Template i is generated with the random seeds (seed,i+1), so pools built
+  with the same spec and seed are identical from job to job. The global
+  fastjet ghost random generator is restored afterwards. select() picks
+  the template from a hash of the input momenta: the ghosts of an event do
+  not depend on the order in which events are processed or on the thread,
+  and all algorithms clustering the same inputs with one pool use the
+  same template.
+
+  Ghosts carry user_index -1, like the ghosts generated by fastjet, and
+  come after the inputs in the clustering history.
+
+*/
+
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/GhostedAreaSpec.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+
+class GhostTemplatePool
+{
+  //
+  // construction / destruction
+  //
+public:
+  GhostTemplatePool(const fastjet::GhostedAreaSpec& ghostSpec,
+		    unsigned nTemplates,int seed);
+  ~GhostTemplatePool();
+
+
+  //
+  // member functions
+  //
+public:
+  unsigned size() const { return templates_.size(); }
+
+  /// index of the template for a clustering of inputs (a hash of their momenta)
+  unsigned select(const std::vector<fastjet::PseudoJet>& inputs) const;
+
+  const std::vector<fastjet::PseudoJet>& ghosts(unsigned i) const { return templates_[i]; }
+  double ghostArea() const { return ghostArea_; }
+
+  /// unique description of template i, e.g. as ClusterSequenceCache key
+  std::string description(unsigned i) const;
+
+  /// cluster the inputs together with the ghosts of template i
+  boost::shared_ptr<fastjet::ClusterSequence>
+  cluster(const std::vector<fastjet::PseudoJet>& inputs,
+	  const fastjet::JetDefinition&          jetDef,
+	  unsigned                               i) const;
+
+
+  //
+  // member data
+  //
+private:
+  fastjet::GhostedAreaSpec                      ghostSpec_;
+  int                                           seed_;
+  double                                        ghostArea_;
+  std::vector<std::vector<fastjet::PseudoJet> > templates_;
+
+};
+
+
+#endif
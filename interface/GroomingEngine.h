@@ -0,0 +1,120 @@
+#ifndef RecoJets_JetAlgorithms_GroomingEngine_h
+#define RecoJets_JetAlgorithms_GroomingEngine_h 1
+
+
+/*
+  GroomingEngine
+  --------------
+
+  Pruned, trimmed and mass-drop/filtered versions of the same C/A fat jets,
+  from one clustering of the event. The inputs are clustered by a
+  FastPrunePlugin with C/A(rParam), which prunes every jet above jetPtMin
+  and keeps the unpruned C/A sequence in its Extras. The other groomers
+  read that sequence:
+
+    - trimming: the C/A exclusive subjets of the fat jet at
+      dcut=(rTrim/rParam)^2 with pt > ptFracTrim*pt(fat jet) are kept.
+      For C/A these are the jets of the constituents reclustered with
+      R=rTrim, as for the filter jets of SubjetFilterAlgorithm.
+    - mass drop and filtering: SubjetFilterAlgorithm::run() on the
+      unpruned sequence.
+
+  Neither reclusters the constituents, and the pruning reclusters the
+  plugin's constituent lists once per fat jet (or, with history pruning,
+  walks the same sequence as well).
+
+  All outputs are aligned by fat jet index: prunedJets[i], trimmedJets[i]
+  and fat jet i of filteredJets are groomed from fatJets[i], the unpruned
+  jets above jetPtMin by decreasing pt. A fat jet failing the mass drop
+  keeps its entry in filteredJets, without subjets. prunedJets[i] is the
+  hardest of the pruned jets from the constituents of fatJets[i]; the
+  pieces pruned away are dropped, and a fat jet without any pruned jet
+  gets a zero four-vector. The constituent indices of filteredJets are the
+  user indices of the inputs.
+
+  No areas are computed. run() is const and reentrant; the set*() methods
+  must be called before the engine is used.
+
+*/
+
+
+#include "RecoJets/JetAlgorithms/interface/FastPrunePlugin.hh"
+#include "RecoJets/JetAlgorithms/interface/SubjetFilterAlgorithm.h"
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
+#include "RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h"
+
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+
+
+/// groomed versions of the fat jets of one event, aligned by fat jet index
+struct GroomedJets
+{
+  void     clear();
+  unsigned size() const { return fatJets.size(); }
+
+  /// the pruned sequence, which through its Extras also keeps the unpruned
+  /// sequence of fatJets, trimmedJets and filteredJets alive
+  boost::shared_ptr<fastjet::ClusterSequence> prunedSequence;
+
+  std::vector<fastjet::PseudoJet> fatJets;
+  std::vector<fastjet::PseudoJet> prunedJets;
+  std::vector<fastjet::PseudoJet> trimmedJets;
+  CompoundPseudoJetCollection     filteredJets;
+};
+
+
+class GroomingEngine
+{
+  //
+  // construction / destruction
+  //
+public:
+  GroomingEngine(double   rParam,        double jetPtMin,
+		 double   zcut,          double rcutFactor,
+		 double   rTrim,         double ptFracTrim,
+		 double   massDropCut,   double asymmCut,
+		 bool     asymmCutLater, double rFilt);
+  ~GroomingEngine();
+
+
+  //
+  // member functions
+  //
+public:
+  /// groom all fat jets of inputs; if cache is given, the pruned sequence
+  /// is shared through the event's cache
+  void run(const std::vector<fastjet::PseudoJet>& inputs,
+	   GroomedJets& jets,
+	   ClusterSequenceCache* cache=0) const;
+
+  /// prune the fat jets concurrently (see FastPrunePlugin)
+  void setParallelPruning(bool parallel) { prunePlugin_->set_parallel_pruning(parallel); }
+  /// prune by walking the unpruned C/A history instead of reclustering
+  /// each fat jet (see FastPrunePlugin::set_history_pruning())
+  void setHistoryPruning(bool history) { prunePlugin_->set_history_pruning(history); }
+
+  const fastjet::JetDefinition& pruneJetDefinition() const { return *pruneJetDef_; }
+
+
+  //
+  // member data
+  //
+private:
+  double rParam_;
+  double rTrim_;
+  double ptFracTrim_;
+
+  boost::shared_ptr<fastjet::FastPrunePlugin> prunePlugin_;
+  boost::shared_ptr<fastjet::JetDefinition>   pruneJetDef_;
+  SubjetFilterAlgorithm                       filter_;
+
+};
+
+
+#endif
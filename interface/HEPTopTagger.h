@@ -293,11 +293,23 @@ void HEPTopTagger::run_tagger()
 	// obtain 3 subjets
 	JetDefinition reclustering(_jet_algorithm_recluster, 3.14/2);
 	
+	std::vector <PseudoJet> top_subs;
+	if (top_constits_filtered.size() >= 3 &&
+	    ::SmallNClusterSequence<>::applicable(top_constits_filtered,reclustering)) {
+	  // few constituents: identical subjets without a ClusterSequence
+	  // (the merged subjets get a CompositeJetStructure of their constituents)
+	  ::SmallNClusterSequence<> cssubtop(top_constits_filtered,reclustering);
+	  std::vector<int> subs;
+	  cssubtop.exclusiveJets(3,subs);
+	  for (unsigned ii = 0; ii < subs.size(); ii++) top_subs.push_back(cssubtop.pseudoJet(subs[ii]));
+	  top_subs = sorted_by_pt(top_subs);
+	} else {
      //// **** NEXT 3 LINES EDITED CKV 12/2/12 **** (edit suggested by G. P. Salam)
      ClusterSequence * cssubtop = new ClusterSequence(top_constits_filtered,reclustering);
-	std::vector <PseudoJet> top_subs = sorted_by_pt(cssubtop->exclusive_jets(3));	      
+	top_subs = sorted_by_pt(cssubtop->exclusive_jets(3));	      
 	cssubtop->delete_self_when_unused();
      //// **** END EDIT ***************************
+	}
      
      _candjets.push_back(top_subs); //
 	
@@ -321,6 +333,21 @@ void HEPTopTagger::run_tagger()
 
 std::vector<fastjet::PseudoJet> HEPTopTagger::Filtering(const std::vector <PseudoJet> & top_constits, const JetDefinition & filtering_def)
 {
+  // few constituents: the small-N kernel gives the same subjets and
+  // constituents without setting up a ClusterSequence
+  if (::SmallNClusterSequence<>::applicable(top_constits,filtering_def)) {
+    ::SmallNClusterSequence<> cstopfilt( top_constits, filtering_def);
+    std::vector<int> filt_top_subjets;
+    cstopfilt.inclusiveJets(filt_top_subjets);
+    cstopfilt.sortByPt(filt_top_subjets);
+    std::vector<PseudoJet> top_constits_filtered;
+    for(unsigned ii = 0; ii<min(_nfilt, filt_top_subjets.size()) ; ii++)
+      {
+	cstopfilt.addConstituents(filt_top_subjets[ii],top_constits_filtered);
+      }
+    return top_constits_filtered;
+  }
+
   // perform filtering
   fastjet::ClusterSequence cstopfilt( top_constits, filtering_def);
  
@@ -0,0 +1,91 @@
+#ifndef RecoJets_JetAlgorithms_JetAreaConfig_h
+#define RecoJets_JetAlgorithms_JetAreaConfig_h 1
+
+
+/*
+  JetAreaConfig
+  -------------
+
+  Jet area configuration shared by the jet algorithms, so that each
+  deployment can trade area accuracy for throughput. The modes, roughly
+  from the cheapest to the most expensive:
+
+    - NoArea:               no areas (plain ClusterSequence)
+    - Voronoi:              Voronoi cell areas of the inputs, scaled by
+                            voronoiRfact; no ghosts
+    - Passive:              passive areas; ghosts are clustered one at a time
+                            (fast for kt and C/A, which use the one-ghost
+                            passive area, not for anti-kt)
+    - Active:               active areas, ghosts averaged over
+                            activeAreaRepeats and removed from the history
+    - ActiveExplicitGhosts: active areas with the ghosts kept in the history
+                            (and the only mode GhostTemplatePool supports)
+
+  The ghost modes use a GhostedAreaSpec(ghostEtaMax,activeAreaRepeats,
+  ghostArea). All modes are read through fastjet::ClusterSequenceAreaBase,
+  and the sequences carry the AreaDefinition description, so
+  ClusterSequenceCache keeps the modes apart.
+
+*/
+
+
+#include <fastjet/AreaDefinition.hh>
+#include <fastjet/GhostedAreaSpec.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+
+
+struct JetAreaConfig
+{
+  //
+  // types
+  //
+  enum Mode { NoArea, Voronoi, Passive, Active, ActiveExplicitGhosts };
+
+
+  //
+  // construction / destruction
+  //
+  JetAreaConfig(Mode   m=NoArea,
+		double etaMax=5.0,int repeats=1,double area=0.01,
+		double rfact=0.9)
+    : mode(m)
+    , ghostEtaMax(etaMax)
+    , activeAreaRepeats(repeats)
+    , ghostArea(area)
+    , voronoiRfact(rfact) {}
+
+
+  //
+  // member functions
+  //
+  bool hasArea()           const { return mode!=NoArea; }
+  bool hasGhosts()         const { return mode==Passive||mode==Active||mode==ActiveExplicitGhosts; }
+  bool hasExplicitGhosts() const { return mode==ActiveExplicitGhosts; }
+
+  fastjet::GhostedAreaSpec ghostSpec() const;
+
+  /// area definition for ClusterSequenceCache/ClusterSequenceArea, null for NoArea
+  boost::shared_ptr<fastjet::AreaDefinition> areaDefinition() const;
+
+  /// mode from its configuration name: "none", "voronoi", "passive",
+  /// "active" or "activeExplicitGhosts"; throws on anything else
+  static Mode        parseMode(const std::string& name);
+  static std::string modeName(Mode m);
+
+
+  //
+  // member data
+  //
+  Mode   mode;
+  double ghostEtaMax;
+  int    activeAreaRepeats;
+  double ghostArea;
+  double voronoiRfact;
+
+};
+
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef RecoJets_JetAlgorithms_JetSplittingRecord_h
+#define RecoJets_JetAlgorithms_JetSplittingRecord_h 1
+
+
+/*
+  JetSplittingRecord
+  ------------------
+
+  Flat record of the clustering history of one jet: every node of the
+  jet's clustering tree is stored once, root first, together with its
+  kinematics and, for nodes that have parents, the kinematics of the
+  splitting into those parents.
+
+  The record is built with a single walk over the ClusterSequence history,
+  after which substructure algorithms (CATopJetAlgorithm declustering,
+  SubjetFilterAlgorithm mass-drop, ...) can take their decisions by
+  scanning the array instead of calling ClusterSequence::has_parents()
+  and recomputing the parent kinematics at every step.
+
+  The record is used by CATopJetAlgorithm, SubjetFilterAlgorithm,
+  SubJetAlgorithm and GroomingEngine only. CMSTopTagger and
+  HEPTopTagger are imported fastjet-style code which still walks the
+  ClusterSequence history with PseudoJet::has_parents().
+
+  As in ClusterSequence::has_parents(), parent1 is always the harder
+  (in pT) of the two parents.
+
+  Exclusive subjets of any node (for a given number of subjets or a given
+  dcut) are read off the record without walking the history again: the
+  recombinations of the node's subtree are undone latest first, as in
+  fastjet, at a cost which scales with the number of subjets rather than
+  the size of the jet.
+  Without explicit ghosts, the results are identical to
+  ClusterSequence::exclusive_subjets[_up_to]().
+
+  For sequences with explicit ghosts, every pure-ghost subtree is stored
+  as a single leaf, so that reset() does not walk the (many) ghost-ghost
+  recombinations. Exclusive subjets therefore never split a pure-ghost
+  node: the results differ from ClusterSequence::exclusive_subjets() only
+  in pure-ghost subjets (and, for a given number of subjets, in the real
+  subjets that the split ghosts would have taken the place of).
+
+  The input indices of the constituents of any node are read off the
+  record as well, skipping the ghosts. They come in record order (harder
+  parent first), which may differ from the order of
+  ClusterSequence::constituents().
+
+*/
+
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/ClusterSequenceAreaBase.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <vector>
+#include <utility>
+
+
+class JetSplittingRecord
+{
+  //
+  // types
+  //
+public:
+  struct Node {
+    int    parent1;     // record index of harder parent, -1 if no parents
+    int    parent2;     // record index of softer parent, -1 if no parents
+    int    histIndex;   // index in ClusterSequence::history()
+    double pt;
+    double m;
+    double m2;
+    double eta;
+    double rapidity;
+    double phi;
+    double dij;         // dij of the recombination that created this node
+    double maxDijSoFar;
+    // splitting variables (parent1+parent2 -> this node), 0 for leaves
+    double z;           // min(pt1,pt2)/(pt1+pt2)
+    double deltaR2;     // parent1.squared_distance(parent2)
+    double kt2;         // parent1.kt_distance(parent2)
+  };
+
+
+  //
+  // construction / destruction
+  //
+public:
+  JetSplittingRecord();
+  JetSplittingRecord(const fastjet::ClusterSequence& cs,
+		     const fastjet::PseudoJet&       jet);
+  ~JetSplittingRecord() {}
+
+
+  //
+  // member functions
+  //
+public:
+  /// rebuild the record for a new jet, reusing the allocated storage
+  void reset(const fastjet::ClusterSequence& cs,const fastjet::PseudoJet& jet);
+
+  unsigned    size()                  const { return nodes_.size(); }
+  bool        empty()                 const { return nodes_.empty(); }
+  const Node& operator[](unsigned i)  const { return nodes_[i]; }
+  const Node& node(unsigned i)        const { return nodes_[i]; }
+
+  /// index of the jet itself
+  int  root()                         const { return 0; }
+  bool hasParents(int i)              const { return nodes_[i].parent1>=0; }
+
+  double deltaR(int i)                const;
+  double kt(int i)                    const;
+
+  /// PseudoJet (owned by the ClusterSequence) corresponding to node i
+  const fastjet::PseudoJet& pseudoJet(int i) const;
+
+  const fastjet::ClusterSequence& clusterSequence() const { return *cs_; }
+
+  /// exclusive subjets of node i: up to nSub subjets, or all subjets at
+  /// dcut, or (last version) several subjet multiplicities at once, from a
+  /// single pass. The subjets are returned as record indices, in history
+  /// order. A negative nSub throws.
+  void exclusiveSubjets(int i,int      nSub,std::vector<int>& subjets) const;
+  void exclusiveSubjets(int i,double   dcut,std::vector<int>& subjets) const;
+  void exclusiveSubjets(int i,const std::vector<int>& nSubs,
+			std::vector<std::vector<int> >& subjets) const;
+  int  nExclusiveSubjets(int i,double dcut) const;
+
+  /// user indices of the (non-ghost) input particles of node i; inputs
+  /// with negative user_index are skipped, as ghosts are
+  void constituents(int i,std::vector<int>& indices) const;
+
+private:
+  void fillExclusiveSubjets(int i,int nMax,double dcut,
+			    std::vector<int>& subjets) const;
+  bool undoNextMerge(std::vector<int>& subjets,size_t& nHeap,double dcut) const;
+
+  struct HistIndexLess {
+    HistIndexLess(const std::vector<Node>& nodes) : nodes_(nodes) {}
+    bool operator()(int i,int j) const { return nodes_[i].histIndex<nodes_[j].histIndex; }
+    const std::vector<Node>& nodes_;
+  };
+  struct NSubLess {
+    NSubLess(const std::vector<int>& nSubs) : nSubs_(nSubs) {}
+    bool operator()(int i,int j) const { return nSubs_[i]<nSubs_[j]; }
+    const std::vector<int>& nSubs_;
+  };
+
+
+  //
+  // member data
+  //
+private:
+  const fastjet::ClusterSequence*   cs_;
+  const fastjet::ClusterSequenceAreaBase* ghosts_; // null without explicit ghosts
+  std::vector<Node>                 nodes_;
+  std::vector<int>                  ends_;      // end of subtree of each node
+  std::vector<std::pair<int,int> >  stack_;     // (history index, +-(child+1))
+
+};
+
+
+#endif
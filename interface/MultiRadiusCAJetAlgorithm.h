@@ -0,0 +1,83 @@
+#ifndef RECOJETS_JETALGORITHMS_MULTIRADIUSCAJETALGORITHM_H
+#define RECOJETS_JETALGORITHMS_MULTIRADIUSCAJETALGORITHM_H 1
+
+
+/*
+  MultiRadiusCAJetAlgorithm
+  -------------------------
+
+  Inclusive Cambridge/Aachen jets for several radii from a single
+  clustering.
+
+  C/A recombines pairs in increasing order of their angular distance DeltaR
+  and stops pairing an object once no partner is closer than R. Clustering
+  with R therefore goes through exactly the recombinations of a clustering
+  with R' < R first: the state of the R history just before its first
+  recombination with DeltaR >= R' *is* the final set of R' jets. The
+  algorithm clusters once with the largest radius and reads the jets for
+  every smaller radius off the history, the same property that
+  SubjetFilterAlgorithm exploits with dcut = Rfilt^2/R^2.
+
+  The jets are identical to the inclusive jets of separate clusterings with
+  the same recombination scheme: pair distances are computed from the
+  parents' phi_02pi() and rap() with the same expression as in the fastjet
+  N^2 strategies, and only exact distance ties may be resolved
+  differently. test/testMultiRadiusCAJetAlgorithm checks this against
+  separate clusterings. Jet areas are not provided.
+
+*/
+
+
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/PseudoJet.hh>
+
+
+class MultiRadiusCAJetAlgorithm
+{
+  //
+  // construction / destruction
+  //
+public:
+  MultiRadiusCAJetAlgorithm(const std::vector<double>& radii,double jetPtMin);
+  virtual ~MultiRadiusCAJetAlgorithm();
+
+
+  //
+  // member functions
+  //
+public:
+  /// cluster inputs with the largest radius, jets[i] are the inclusive jets
+  /// (pt > jetPtMin, sorted by pt) for radii()[i]
+  void run(const std::vector<fastjet::PseudoJet>& inputs,
+	   std::vector<std::vector<fastjet::PseudoJet> >& jets,
+	   boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq) const;
+
+  /// same, for an existing C/A sequence with R >= all radii()
+  void run(const fastjet::ClusterSequence& cs,
+	   std::vector<std::vector<fastjet::PseudoJet> >& jets) const;
+
+  /// inclusive jets of radius r < cs.jet_def().R(), read off cs
+  void inclusiveJets(const fastjet::ClusterSequence& cs,double r,
+		     std::vector<fastjet::PseudoJet>& jets) const;
+
+  const std::vector<double>&    radii()         const { return radii_; }
+  const fastjet::JetDefinition& jetDefinition() const { return fjJetDef_; }
+
+
+  //
+  // member data
+  //
+private:
+  std::vector<double>      radii_;
+  double                   jetPtMin_;
+  fastjet::JetDefinition   fjJetDef_;
+
+};
+
+
+#endif
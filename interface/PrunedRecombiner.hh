@@ -37,13 +37,19 @@ public:
 		_recombiner = &_default_recombiner;
 	}
 
+	// copies start with no pruned pseudojets; a copy made from a scheme
+	//   uses its own DefaultRecombiner.  This lets each clustering work on
+	//   its own copy of a shared prototype.
+	PrunedRecombiner(const PrunedRecombiner & other);
+	PrunedRecombiner & operator=(const PrunedRecombiner & other);
+
 	virtual std::string description() const;
 	
 	// recombine pa and pb and put result into pab
 	virtual void recombine(const PseudoJet & pa, const PseudoJet & pb, 
 	                       PseudoJet & pab) const;
 
-	std::vector<int> pruned_pseudojets() { return _pruned_pseudojets; }
+	const std::vector<int> & pruned_pseudojets() const { return _pruned_pseudojets; }
 
 	// resets pruned_pseudojets vector, parameters
 	void reset(const double & zcut, const double & Rcut);
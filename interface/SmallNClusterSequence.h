@@ -0,0 +1,482 @@
+#ifndef RecoJets_JetAlgorithms_SmallNClusterSequence_h
+#define RecoJets_JetAlgorithms_SmallNClusterSequence_h 1
+
+
+/*
+  SmallNClusterSequence
+  ---------------------
+
+  Clustering kernel for a few to a few dozen inputs (filtering and
+  reclustering of subjets, e.g. in the HEPTopTagger), where the setup and
+  allocations of a fastjet::ClusterSequence dominate the clustering itself.
+
+  The kernel is the brute-force N^2 algorithm which fastjet runs for small N
+  (ClusterSequence::_simple_N2_cluster, chosen by the Best strategy if
+  min(1,3.3*max(0.1,R))*N <= 30): same nearest-neighbour bookkeeping, same
+  tie-breaking and same recombination order, so that the history, jets and
+  constituents are identical to those of the ClusterSequence. It differs in
+  that
+    - all storage has the fixed capacity MaxN inputs and lives in the
+      object (on the stack), nothing is allocated while clustering,
+    - the distances are computed in separate loops over the flat
+      rapidity/phi arrays, which the compiler can vectorise,
+    - the jet scale (kt^2, 1 or 1/kt^2) is selected at compile time for the
+      kt, Cambridge/Aachen and anti-kt algorithms; for C/A the d_iJ are the
+      plain distances.
+
+  applicable() tells whether the kernel reproduces the ClusterSequence for
+  given inputs and jet definition (kt, C/A or anti-kt without plugin, Best
+  or N2Plain strategy, fastjet's N2Plain threshold and at most MaxN
+  inputs); callers fall back to fastjet::ClusterSequence otherwise.
+
+  Jets are identified by their history index, as in fastjet. pseudoJet()
+  returns merged jets with a fastjet::CompositeJetStructure of their
+  constituents, since they have no ClusterSequence to refer to; input jets
+  are returned as they were passed (after recombiner preprocessing). The
+  jet definition must stay valid as long as the sequence is used.
+
+*/
+
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/CompositeJetStructure.hh>
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/PseudoJet.hh>
+#include <fastjet/SharedPtr.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+/// jet scale of the algorithms, as fastjet::ClusterSequence::jet_scale_for_algorithm()
+template<int Algorithm> struct SmallNJetScale;
+
+template<> struct SmallNJetScale<fastjet::kt_algorithm> {
+  static double value(const fastjet::PseudoJet& jet) { return jet.kt2(); }
+  static double min(double kt2a,double kt2b) { return (kt2b<kt2a) ? kt2b : kt2a; }
+};
+
+template<> struct SmallNJetScale<fastjet::cambridge_algorithm> {
+  static double value(const fastjet::PseudoJet&) { return 1.0; }
+  static double min(double,double) { return 1.0; }
+};
+
+template<> struct SmallNJetScale<fastjet::antikt_algorithm> {
+  static double value(const fastjet::PseudoJet& jet) {
+    double kt2 = jet.kt2(); return (kt2>1e-300) ? 1.0/kt2 : 1e300;
+  }
+  static double min(double kt2a,double kt2b) { return (kt2b<kt2a) ? kt2b : kt2a; }
+};
+
+
+template<unsigned MaxN=32>
+class SmallNClusterSequence
+{
+  //
+  // construction / destruction
+  //
+public:
+  SmallNClusterSequence(const std::vector<fastjet::PseudoJet>& inputs,
+			const fastjet::JetDefinition&          jetDef);
+
+
+  //
+  // member functions
+  //
+public:
+  /// true if the kernel gives the same result as fastjet::ClusterSequence
+  static bool applicable(const std::vector<fastjet::PseudoJet>& inputs,
+			 const fastjet::JetDefinition&          jetDef);
+
+  unsigned n()        const { return n_; }
+  int      nHistory() const { return nHist_; }
+
+  /// 4-momentum of history element i
+  const fastjet::PseudoJet& jet(int i) const { return jets_[jetIndex_[i]]; }
+
+  /// history element i as PseudoJet, see above
+  fastjet::PseudoJet pseudoJet(int i) const;
+
+  /// history indices of the inclusive jets above ptMin, in the order of
+  /// ClusterSequence::inclusive_jets()
+  void inclusiveJets(std::vector<int>& jets,double ptMin=0.0) const;
+
+  /// history indices of the exclusive jets, in the order of
+  /// ClusterSequence::exclusive_jets()
+  void exclusiveJets(int nJets,std::vector<int>& jets) const;
+
+  /// order history indices as fastjet::sorted_by_pt() orders the jets
+  void sortByPt(std::vector<int>& jets) const;
+
+  /// append the inputs of history element i, as ClusterSequence::add_constituents()
+  void addConstituents(int i,std::vector<fastjet::PseudoJet>& constituents) const;
+
+private:
+  template<int Algorithm> void cluster();
+  template<int Algorithm> double diJ(int a) const;
+
+  void   setJetInfo(int a,int k,double kt2);
+  void   distances(int a,int begin,int end,double* d) const;
+  void   recombine(int ka,int kb,double dij,int& k);
+  void   recombineBeam(int ka,double dij);
+  void   addHistory(int parent1,int parent2,int k,double dij);
+
+
+  //
+  // member data
+  //
+private:
+  const fastjet::JetDefinition::Recombiner* recombiner_;
+  int                algorithm_;
+  double             r2_;
+  unsigned           n_;
+
+  // jets: inputs, then recombinations
+  fastjet::PseudoJet jets_[2*MaxN];
+  int                jetHist_[2*MaxN];
+  unsigned           nJets_;
+
+  // history
+  int                parent1_[2*MaxN];
+  int                parent2_[2*MaxN];
+  int                jetIndex_[2*MaxN];
+  double             dij_[2*MaxN];
+  double             maxDij_[2*MaxN];
+  int                nHist_;
+
+  // active jets ("brief jets") and their nearest neighbours
+  double             rap_[MaxN];
+  double             phi_[MaxN];
+  double             kt2_[MaxN];
+  int                index_[MaxN];
+  int                nn_[MaxN];
+  double             nnDist_[MaxN];
+  double             diJ_[MaxN];
+
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+SmallNClusterSequence<MaxN>::SmallNClusterSequence(const std::vector<fastjet::PseudoJet>& inputs,
+						   const fastjet::JetDefinition& jetDef)
+  : recombiner_(jetDef.recombiner())
+  , algorithm_(jetDef.jet_algorithm())
+  , r2_(jetDef.R()*jetDef.R())
+  , n_(inputs.size())
+  , nJets_(0)
+  , nHist_(0)
+{
+  if (n_>MaxN)
+    throw cms::Exception("InvalidParameter")
+      <<"SmallNClusterSequence: "<<n_<<" inputs exceed the capacity of "<<MaxN<<"\n";
+
+  for (unsigned i=0;i<n_;i++) {
+    jets_[i] = inputs[i];
+    recombiner_->preprocess(jets_[i]);
+    jetHist_[i] = i;
+    addHistory(fastjet::ClusterSequence::InexistentParent,
+	       fastjet::ClusterSequence::InexistentParent,i,0.0);
+  }
+  nJets_ = n_;
+
+  switch (algorithm_) {
+  case fastjet::kt_algorithm:        cluster<fastjet::kt_algorithm>();        break;
+  case fastjet::cambridge_algorithm: cluster<fastjet::cambridge_algorithm>(); break;
+  case fastjet::antikt_algorithm:    cluster<fastjet::antikt_algorithm>();    break;
+  default:
+    throw cms::Exception("InvalidJetAlgo")
+      <<"SmallNClusterSequence: only kt, Cambridge/Aachen and anti-kt are supported\n";
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+bool SmallNClusterSequence<MaxN>::applicable(const std::vector<fastjet::PseudoJet>& inputs,
+					     const fastjet::JetDefinition& jetDef)
+{
+  if (inputs.size()>MaxN) return false;
+  fastjet::JetAlgorithm algorithm = jetDef.jet_algorithm();
+  if (algorithm!=fastjet::kt_algorithm&&
+      algorithm!=fastjet::cambridge_algorithm&&
+      algorithm!=fastjet::antikt_algorithm) return false;
+  if (jetDef.strategy()==fastjet::N2Plain) return true;
+  if (jetDef.strategy()!=fastjet::Best)    return false;
+  return std::min(1.0,std::max(0.1,jetDef.R())*3.3)*inputs.size()<=30;
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+fastjet::PseudoJet SmallNClusterSequence<MaxN>::pseudoJet(int i) const
+{
+  if (parent1_[i]==fastjet::ClusterSequence::InexistentParent) return jet(i);
+  std::vector<fastjet::PseudoJet> constituents;
+  addConstituents(i,constituents);
+  fastjet::PseudoJet result(jet(i));
+  result.set_structure_shared_ptr(fastjet::SharedPtr<fastjet::PseudoJetStructureBase>
+				  (new fastjet::CompositeJetStructure(constituents,recombiner_)));
+  return result;
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::inclusiveJets(std::vector<int>& jets,double ptMin) const
+{
+  double dcut = ptMin*ptMin;
+  jets.clear();
+  // as in fastjet: kt and C/A walk the history backwards and stop early,
+  // the other algorithms walk it forwards
+  if (algorithm_==fastjet::kt_algorithm) {
+    for (int i=nHist_-1;i>=0;i--) {
+      if (maxDij_[i]<dcut) break;
+      if (parent2_[i]==fastjet::ClusterSequence::BeamJet&&dij_[i]>=dcut)
+	jets.push_back(parent1_[i]);
+    }
+  }
+  else if (algorithm_==fastjet::cambridge_algorithm) {
+    for (int i=nHist_-1;i>=0;i--) {
+      if (parent2_[i]!=fastjet::ClusterSequence::BeamJet) break;
+      if (jet(parent1_[i]).perp2()>=dcut) jets.push_back(parent1_[i]);
+    }
+  }
+  else {
+    for (int i=0;i<nHist_;i++)
+      if (parent2_[i]==fastjet::ClusterSequence::BeamJet&&
+	  jet(parent1_[i]).perp2()>=dcut) jets.push_back(parent1_[i]);
+  }
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::exclusiveJets(int nJets,std::vector<int>& jets) const
+{
+  if (nJets>int(n_))
+    throw cms::Exception("InvalidParameter")
+      <<"SmallNClusterSequence: requested "<<nJets<<" exclusive jets from "
+      <<n_<<" inputs\n";
+  int stop = 2*n_-nJets;
+  jets.clear();
+  for (int i=stop;i<nHist_;i++) {
+    if (parent1_[i]<stop) jets.push_back(parent1_[i]);
+    if (parent2_[i]<stop&&parent2_[i]>0) jets.push_back(parent2_[i]);
+  }
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::sortByPt(std::vector<int>& jets) const
+{
+  std::vector<double> minusKt2(jets.size());
+  std::vector<int>    indices(jets.size());
+  for (size_t i=0;i<jets.size();i++) {
+    minusKt2[i] = -jet(jets[i]).kt2();
+    indices[i]  = i;
+  }
+  fastjet::sort_indices(indices,minusKt2);
+  std::vector<int> sorted(jets.size());
+  for (size_t i=0;i<jets.size();i++) sorted[i] = jets[indices[i]];
+  jets.swap(sorted);
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::addConstituents(int i,
+						  std::vector<fastjet::PseudoJet>& constituents) const
+{
+  if (parent1_[i]==fastjet::ClusterSequence::InexistentParent) {
+    constituents.push_back(jet(i));
+    return;
+  }
+  addConstituents(parent1_[i],constituents);
+  if (parent2_[i]!=fastjet::ClusterSequence::BeamJet)
+    addConstituents(parent2_[i],constituents);
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+template<int Algorithm>
+void SmallNClusterSequence<MaxN>::cluster()
+{
+  typedef SmallNJetScale<Algorithm> Scale;
+
+  double d[MaxN];   // distances to the new jet, or of the jet being set up
+  double dNN[MaxN]; // distances of a jet which lost its nearest neighbour
+  int    n    = n_;
+  int    tail = n_;
+
+  for (int a=0;a<n;a++) setJetInfo(a,a,Scale::value(jets_[a]));
+
+  // nearest neighbours, each pair once (crosscheck)
+  for (int a=1;a<tail;a++) {
+    distances(a,0,a,d);
+    double nnDist = r2_;
+    int    nn     = -1;
+    for (int b=0;b<a;b++) {
+      if (d[b]<nnDist)     { nnDist = d[b]; nn = b; }
+      if (d[b]<nnDist_[b]) { nnDist_[b] = d[b]; nn_[b] = a; }
+    }
+    nn_[a]     = nn;
+    nnDist_[a] = nnDist;
+  }
+
+  for (int a=0;a<n;a++) diJ_[a] = diJ<Algorithm>(a);
+
+  double invR2 = 1.0/r2_;
+  while (tail!=0) {
+    double diJMin = diJ_[0];
+    int    a      = 0;
+    for (int i=1;i<n;i++) if (diJ_[i]<diJMin) { a = i; diJMin = diJ_[i]; }
+
+    int b = nn_[a];
+    diJMin *= invR2;
+
+    if (b>=0) {
+      // as in fastjet, the new jet takes the lower of the two slots
+      if (a<b) std::swap(a,b);
+      int k;
+      recombine(index_[a],index_[b],diJMin,k);
+      setJetInfo(b,k,Scale::value(jets_[k]));
+    }
+    else {
+      recombineBeam(index_[a],diJMin);
+    }
+
+    // the last jet moves into the slot of a
+    tail--; n--;
+    rap_[a]    = rap_[tail];
+    phi_[a]    = phi_[tail];
+    kt2_[a]    = kt2_[tail];
+    index_[a]  = index_[tail];
+    nn_[a]     = nn_[tail];
+    nnDist_[a] = nnDist_[tail];
+    diJ_[a]    = diJ_[tail];
+
+    if (b>=0) distances(b,0,tail,d);
+
+    for (int i=0;i<tail;i++) {
+      // lost its nearest neighbour (b<0: fastjet compares with a null jetB)
+      if (nn_[i]==a||nn_[i]==b) {
+	distances(i,0,tail,dNN);
+	double nnDist = r2_;
+	int    nn     = -1;
+	for (int j=0;j<tail;j++)
+	  if (j!=i&&dNN[j]<nnDist) { nnDist = dNN[j]; nn = j; }
+	nn_[i]     = nn;
+	nnDist_[i] = nnDist;
+	diJ_[i]    = diJ<Algorithm>(i);
+      }
+      // the new jet may be closer than the current nearest neighbour
+      if (b>=0&&i!=b) {
+	if (d[i]<nnDist_[i]) {
+	  nnDist_[i] = d[i];
+	  nn_[i]     = b;
+	  diJ_[i]    = diJ<Algorithm>(i);
+	}
+	if (d[i]<nnDist_[b]) {
+	  nnDist_[b] = d[i];
+	  nn_[b]     = i;
+	}
+      }
+      if (nn_[i]==tail) nn_[i] = a;
+    }
+
+    if (b>=0) diJ_[b] = diJ<Algorithm>(b);
+  }
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+template<int Algorithm>
+double SmallNClusterSequence<MaxN>::diJ(int a) const
+{
+  double kt2 = kt2_[a];
+  if (nn_[a]>=0) kt2 = SmallNJetScale<Algorithm>::min(kt2,kt2_[nn_[a]]);
+  return nnDist_[a]*kt2;
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::setJetInfo(int a,int k,double kt2)
+{
+  rap_[a]    = jets_[k].rap();
+  phi_[a]    = jets_[k].phi_02pi();
+  kt2_[a]    = kt2;
+  index_[a]  = k;
+  nnDist_[a] = r2_;
+  nn_[a]     = -1;
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::distances(int a,int begin,int end,double* d) const
+{
+  double rap = rap_[a];
+  double phi = phi_[a];
+  for (int b=begin;b<end;b++) {
+    double dphi = std::abs(phi-phi_[b]);
+    double drap = rap-rap_[b];
+    dphi = (dphi>fastjet::pi) ? fastjet::twopi-dphi : dphi;
+    d[b] = dphi*dphi+drap*drap;
+  }
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::recombine(int ka,int kb,double dij,int& k)
+{
+  fastjet::PseudoJet newJet;
+  recombiner_->recombine(jets_[ka],jets_[kb],newJet);
+  k = nJets_++;
+  jets_[k] = newJet;
+  int histA = jetHist_[ka];
+  int histB = jetHist_[kb];
+  jetHist_[k] = nHist_;
+  addHistory(std::min(histA,histB),std::max(histA,histB),k,dij);
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::recombineBeam(int ka,double dij)
+{
+  addHistory(jetHist_[ka],fastjet::ClusterSequence::BeamJet,
+	     fastjet::ClusterSequence::Invalid,dij);
+}
+
+
+//______________________________________________________________________________
+template<unsigned MaxN>
+void SmallNClusterSequence<MaxN>::addHistory(int parent1,int parent2,int k,double dij)
+{
+  parent1_[nHist_]  = parent1;
+  parent2_[nHist_]  = parent2;
+  jetIndex_[nHist_] = k;
+  dij_[nHist_]      = dij;
+  maxDij_[nHist_]   = (nHist_>0) ? std::max(dij,maxDij_[nHist_-1]) : dij;
+  nHist_++;
+}
+
+
+#endif
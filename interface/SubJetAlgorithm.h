@@ -4,8 +4,10 @@
 #include <vector>
 
 #include "RecoJets/JetAlgorithms/interface/CompoundPseudoJet.h"
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
 #include "FWCore/Framework/interface/Event.h"
 #include "RecoJets/JetAlgorithms/interface/FastPrunePlugin.hh"
+#include "RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h"
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/PseudoJet.hh>
 #include <fastjet/ClusterSequence.hh>
@@ -30,19 +32,62 @@ class SubJetAlgorithm{
     fjJetDefinition_(fjJetDefinition),
     doAreaFastjet_ (doAreaFastjet),
     fjActiveArea_  (fjActiveArea),
-    voronoiRfact_  (voronoiRfact)
+    voronoiRfact_  (voronoiRfact),
+    storeFourVectors_(false),
+    lazyAreas_     (false),
+    nAreaJets_     (0)
       { 
-	
+	makePrunePlugin();
       }
 
+  /// the pruning plugin is rebuilt; the old one is deleted with the last
+  /// cluster sequence (e.g. in a ClusterSequenceCache) that uses it
   void set_zcut(double z);
   void set_rcut_factor(double r);
   double zcut() const { return zcut_;}
   double rcut_factor() const { return rcut_factor_; }
+  /// store plain 4-vectors in the CompoundPseudoJet output, so that the
+  /// cluster sequence is freed when run() returns (see CompoundPseudoJetCollection)
+  void set_store_four_vectors(bool b) { storeFourVectors_ = b; }
+  bool store_four_vectors() const { return storeFourVectors_; }
+  /// compute the areas only when they are accessed in the output collection
+  /// (see CompoundPseudoJetCollection), and/or only for the leading n hard
+  /// jets and their subjets (0: all); the others get area 0. Output
+  /// collections with FourVectors storage get their areas eagerly, so
+  /// that they do not keep the cluster sequence alive.
+  void set_lazy_areas(bool b) { lazyAreas_ = b; }
+  void set_n_area_jets(unsigned n) { nAreaJets_ = n; }
 
   /// Find the ProtoJets from the collection of input Candidates.
+  /// If cache is given, the pruned cluster sequence is taken from (and
+  /// stored in) the event's ClusterSequenceCache.
   void run( const std::vector<fastjet::PseudoJet> & cell_particles, 
-	    std::vector<CompoundPseudoJet> & hardjetsOutput);
+	    std::vector<CompoundPseudoJet> & hardjetsOutput,
+	    ClusterSequenceCache * cache = 0 );
+
+  /// same, filling a flat collection (which can be reused across events)
+  void run( const std::vector<fastjet::PseudoJet> & cell_particles, 
+	    CompoundPseudoJetCollection & hardjetsOutput,
+	    ClusterSequenceCache * cache = 0 );
+
+  /// same, also appending for every hard jet the unpruned jet it was pruned
+  /// from, and its area, matched by index. The unpruned jets come from the
+  /// pruning plugin's own unpruned clustering, so no separate clustering is
+  /// needed for them. With Voronoi areas, their area is the sum of the
+  /// Voronoi areas of their inputs. Active areas are not additive over the
+  /// inputs: they come from one more (ghosted) clustering of the inputs with
+  /// the unpruned jet definition, taken from the cache if given. Without
+  /// areas, the unpruned areas are 0.
+  void run( const std::vector<fastjet::PseudoJet> & cell_particles, 
+	    std::vector<CompoundPseudoJet> & hardjetsOutput,
+	    std::vector<fastjet::PseudoJet> & unprunedJets,
+	    std::vector<double> & unprunedAreas,
+	    ClusterSequenceCache * cache = 0 );
+  void run( const std::vector<fastjet::PseudoJet> & cell_particles, 
+	    CompoundPseudoJetCollection & hardjetsOutput,
+	    std::vector<fastjet::PseudoJet> & unprunedJets,
+	    std::vector<double> & unprunedAreas,
+	    ClusterSequenceCache * cache = 0 );
 
 
  private:
@@ -55,6 +100,20 @@ class SubJetAlgorithm{
   bool                doAreaFastjet_; //<! whether or not to use the fastjet area
   boost::shared_ptr<fastjet::GhostedAreaSpec> fjActiveArea_; //<! fastjet area spec
   double              voronoiRfact_;  //<! fastjet voronoi area R factor
+  bool                storeFourVectors_; //<! output PseudoJets detached from the cluster sequence
+  bool                lazyAreas_;     //<! compute areas on first access
+  unsigned            nAreaJets_;     //<! number of leading hard jets with areas (0: all)
+  boost::shared_ptr<fastjet::JetDefinition> fjPruneJetDef_;  //<! owns the pruning plugin, rebuilt when zcut or rcut_factor change
+
+  /// (re)build the pruning plugin and its jet definition for the current parameters
+  void makePrunePlugin();
+
+  /// does the actual work for all run() versions, unpruned jets if not null
+  void findJets( const std::vector<fastjet::PseudoJet> & cell_particles, 
+		 CompoundPseudoJetCollection & hardjetsOutput,
+		 std::vector<fastjet::PseudoJet> * unprunedJets,
+		 std::vector<double> * unprunedAreas,
+		 ClusterSequenceCache * cache );
 };
 
 #endif
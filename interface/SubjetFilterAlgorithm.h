@@ -11,23 +11,67 @@
 
   see: https://twiki.cern.ch/twiki/bin/view/CMS/SWGuideSubjetFilterJetProducer
 
+  run() and runScan() are const and reentrant, so that one instance can be
+  shared by concurrent event streams (each with its own output collections
+  and ClusterSequenceCache). The event statistics and the clustering and
+  filtering times are accumulated in atomic counters and reported by
+  summary(). The set*() configuration methods are not thread-safe and must
+  be called before the algorithm is used.
+
+  The ghost area modes (including the default doAreaFastjet mode) generate
+  their ghosts with fastjet's process-global random generator, which is
+  not thread-safe: their clusterings are serialized by
+  ClusterSequenceCache::cluster(), across all algorithms of this package,
+  but code outside it drawing ghosts in other threads is not protected
+  against. Only the NoArea and Voronoi modes, and ghost templates
+  (setGhostTemplates()), cluster concurrently.
+
 */
 
 
 #include <vector>
 
 #include "RecoJets/JetAlgorithms/interface/CompoundPseudoJet.h"
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
+#include "RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h"
+#include "RecoJets/JetAlgorithms/interface/GhostTemplatePool.h"
+#include "RecoJets/JetAlgorithms/interface/JetAreaConfig.h"
 #include "FWCore/Framework/interface/Event.h"
 
+#include <boost/shared_ptr.hpp>
+
+#include "tbb/atomic.h"
+#include "tbb/tick_count.h"
+
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/AreaDefinition.hh>
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/ClusterSequenceAreaBase.hh>
 #include <fastjet/PseudoJet.hh>
 
 
 
 
+class JetSplittingRecord;
+
+
 class SubjetFilterAlgorithm
 {
+  //
+  // types
+  //
+public:
+  /// the parameters of the mass-drop and filtering steps, for runScan()
+  struct Parameters {
+    Parameters(double md,double asymm,bool asymmLater,double rf)
+      : massDropCut(md), asymmCut(asymm), asymmCutLater(asymmLater), rFilt(rf) {}
+    double massDropCut;
+    double asymmCut;
+    bool   asymmCutLater;
+    double rFilt;
+  };
+  
+  
   //
   // construction / destruction
   //
@@ -49,10 +93,95 @@ public:
 public:
   void run(const std::vector<fastjet::PseudoJet>& inputs, 
 	   std::vector<CompoundPseudoJet>& fatJets,
-	   const edm::EventSetup& iSetup);
+	   const edm::EventSetup& iSetup) const;
+  
+  /// same, keeping the cluster sequence, e.g. for runScaleVariations(); if
+  /// cache is given, the sequence is shared through the event's cache
+  void run(const std::vector<fastjet::PseudoJet>& inputs, 
+	   std::vector<CompoundPseudoJet>& fatJets,
+	   boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq,
+	   ClusterSequenceCache* cache=0) const;
+  
+  /// same, filling a flat collection (which can be reused across events);
+  /// the collection's owner index, if enabled, gives the fat jet and subjet
+  /// of each input (mass-drop subjets win over the filter jets they overlap)
+  void run(const std::vector<fastjet::PseudoJet>& inputs, 
+	   CompoundPseudoJetCollection& fatJets,
+	   boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq,
+	   ClusterSequenceCache* cache=0) const;
+  
+  /// same, from an existing cluster sequence (e.g. shared with other
+  /// groomers, see GroomingEngine), appending to fatJets; the event
+  /// statistics are not updated. With lazy areas, the areas are only
+  /// deferred if cs is the area sequence of fatJets (setAreaSequence()).
+  void run(const fastjet::ClusterSequence& cs,
+	   CompoundPseudoJetCollection& fatJets) const;
+  
+  /// momentum-scale (JES) variations from an existing cluster sequence:
+  /// fatJets[i] is the result for all inputs scaled by scales[i]. The
+  /// clustering history does not change under a uniform scale and the
+  /// mass-drop/asymmetry/filtering decisions are scale invariant, so only
+  /// the fat jet pt threshold is reevaluated and the 4-vectors are scaled.
+  /// The constituents still refer to the unscaled inputs. With
+  /// setStoreFourVectors(), the jets are plain 4-vectors, without cs.
+  void runScaleVariations(const fastjet::ClusterSequence& cs,
+			  const std::vector<double>& scales,
+			  std::vector<std::vector<CompoundPseudoJet> >& fatJets) const;
+  
+  /// parameter scan (tuning, systematics): cluster once and run the
+  /// mass-drop and filtering steps for each parameter set, fatJets[i] for
+  /// parameters[i]. Each fat jet's clustering record and mass-drop path
+  /// are built once and shared by all sets. The event statistics are not
+  /// updated.
+  void runScan(const std::vector<fastjet::PseudoJet>& inputs,
+	       const std::vector<Parameters>& parameters,
+	       std::vector<CompoundPseudoJetCollection>& fatJets,
+	       boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq,
+	       ClusterSequenceCache* cache=0) const;
+  
+  /// same, from an existing cluster sequence (lazy areas as for run())
+  void runScan(const fastjet::ClusterSequence& cs,
+	       const std::vector<Parameters>& parameters,
+	       std::vector<CompoundPseudoJetCollection>& fatJets) const;
+  
+  /// store plain 4-vectors in the CompoundPseudoJet output, so that the
+  /// cluster sequence is freed when run() returns (see CompoundPseudoJetCollection)
+  void setStoreFourVectors(bool storeFourVectors) { storeFourVectors_=storeFourVectors; }
+  
+  /// select the area mode (see JetAreaConfig); the constructor's
+  /// doAreaFastjet chooses between NoArea and ActiveExplicitGhosts. A
+  /// ghost template pool is dropped unless the mode has explicit ghosts.
+  void setAreaConfig(const JetAreaConfig& areaConfig);
+  const JetAreaConfig& areaConfig() const { return areaConfig_; }
+  
+  /// take the area ghosts from a pool of nTemplates precomputed ghost sets
+  /// (see GhostTemplatePool) instead of generating them for every event;
+  /// only for the ActiveExplicitGhosts area mode
+  void setGhostTemplates(unsigned nTemplates,int seed);
+  
+  /// compute the areas only when they are accessed in the output collection
+  /// (see CompoundPseudoJetCollection), and/or only for the leading
+  /// nAreaJets fat jets and their subjets (0: all); the others get area 0.
+  /// Output collections with FourVectors storage (setStoreFourVectors())
+  /// get their areas eagerly, so that they do not keep the sequence alive.
+  void setLazyAreas(bool lazyAreas) { lazyAreas_=lazyAreas; }
+  void setNAreaJets(unsigned nAreaJets) { nAreaJets_=nAreaJets; }
   
   std::string summary() const;
   
+private:
+  boost::shared_ptr<fastjet::ClusterSequence>
+  cluster(const std::vector<fastjet::PseudoJet>& inputs,ClusterSequenceCache* cache) const;
+  void filterJets(const fastjet::ClusterSequence& cs,double jetPtMin,
+		  CompoundPseudoJetCollection& fatJets) const;
+  void filterJets(const fastjet::ClusterSequence& cs,double jetPtMin,
+		  const std::vector<Parameters>& parameters,
+		  const std::vector<CompoundPseudoJetCollection*>& fatJets) const;
+  static double nodeArea(const JetSplittingRecord& record,
+			 const fastjet::ClusterSequenceAreaBase* csArea,
+			 std::vector<double>& nodeAreas,int i);
+  static unsigned long long nanoseconds(const tbb::tick_count::interval_t& dt);
+  
   
   //
   // member data
@@ -67,18 +196,21 @@ private:
   double                   massDropCut_;
   double                   asymmCut2_;
   bool                     asymmCutLater_;
-  bool                     doAreaFastjet_;
-  double                   ghostEtaMax_;
-  int                      activeAreaRepeats_;
-  double                   ghostArea_;
+  JetAreaConfig            areaConfig_;
   bool                     verbose_;
+  bool                     storeFourVectors_;
+  bool                     lazyAreas_;
+  unsigned                 nAreaJets_;
   
-  unsigned                 nevents_;
-  unsigned                 ntotal_;
-  unsigned                 nfound_;
+  mutable tbb::atomic<unsigned long>      nevents_;
+  mutable tbb::atomic<unsigned long>      ntotal_;
+  mutable tbb::atomic<unsigned long>      nfound_;
+  mutable tbb::atomic<unsigned long long> clusteringTimeNs_;
+  mutable tbb::atomic<unsigned long long> filteringTimeNs_;
   
-  fastjet::JetDefinition*  fjJetDef_;
-  fastjet::AreaDefinition* fjAreaDef_;
+  boost::shared_ptr<fastjet::JetDefinition>  fjJetDef_;
+  boost::shared_ptr<fastjet::AreaDefinition> fjAreaDef_;
+  boost::shared_ptr<GhostTemplatePool> ghostPool_;
 
 };
 
@@ -15,6 +15,43 @@ using namespace reco;
 using namespace edm;
 
 
+//  Cluster the inputs for run()
+//  -----------------------------
+boost::shared_ptr<fastjet::ClusterSequence> CATopJetAlgorithm::cluster( const vector<fastjet::PseudoJet> & cell_particles,
+									ClusterSequenceCache * cache
+									) const
+{
+	int sumEtBinId = sumEtBin( cell_particles, 1.0 );
+	if ( sumEtBinId < 0 ) return boost::shared_ptr<fastjet::ClusterSequence>();
+	
+	return cluster( cell_particles, sumEtBinId, cache );
+}
+
+
+//  Cluster the inputs with the R of a given sumEt bin
+//  ---------------------------------------------------
+boost::shared_ptr<fastjet::ClusterSequence> CATopJetAlgorithm::cluster( const vector<fastjet::PseudoJet> & cell_particles,
+									int sumEtBinId,
+									ClusterSequenceCache * cache
+									) const
+{
+	fastjet::JetAlgorithm fjAlgorithm;
+	switch ( algorithm_ ) {
+	case 0 : fjAlgorithm = fastjet::kt_algorithm;        break;
+	case 1 : fjAlgorithm = fastjet::cambridge_algorithm; break;
+	case 2 : fjAlgorithm = fastjet::antikt_algorithm;    break;
+	default:
+		throw cms::Exception("InvalidJetAlgo") << "CATopJetAlgorithm: invalid algorithm " << algorithm_ << "\n";
+	}
+	fastjet::JetDefinition jetDef( fjAlgorithm, rBins_[sumEtBinId] );
+	boost::shared_ptr<fastjet::AreaDefinition> areaDef = areaConfig_.areaDefinition();
+	
+	return ( cache != 0 ) ?
+		cache->get( cell_particles, jetDef, areaDef.get() ) :
+		ClusterSequenceCache::cluster( cell_particles, jetDef, areaDef.get() );
+}
+
+
 //  Run the algorithm
 //  ------------------
 void CATopJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles, 
@@ -24,21 +61,76 @@ void CATopJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles,
 {
 	if ( verbose_ ) cout << "Welcome to CATopSubJetAlgorithm::run" << endl;
 	
+	// no sequence from cluster(): the event is below the lowest sumEt bin
+	if ( fjClusterSeq.get() == 0 ) return;
+	
+	findTopJets( cell_particles, *fjClusterSeq, 1.0, hardjetsOutput );
+}
+
+
+//  Momentum-scale variations on an existing cluster sequence
+//  ----------------------------------------------------------
+void CATopJetAlgorithm::runScaleVariations( const vector<fastjet::PseudoJet> & cell_particles,
+					    const boost::shared_ptr<fastjet::ClusterSequence> & fjClusterSeq,
+					    const vector<double> & scales,
+					    vector<vector<fastjet::PseudoJet> > & hardjetsOutput,
+					    vector<boost::shared_ptr<fastjet::ClusterSequence> > & fjClusterSeqs,
+					    ClusterSequenceCache * cache
+					    ) const
+{
+	hardjetsOutput.resize( scales.size() );
+	fjClusterSeqs.resize( scales.size() );
+	for ( unsigned int i = 0; i < scales.size(); ++i ) {
+		if ( scales[i] <= 0. )
+			throw cms::Exception("InvalidParameter") << "CATopJetAlgorithm: invalid momentum scale " << scales[i] << "\n";
+		hardjetsOutput[i].clear();
+		fjClusterSeqs[i].reset();
+		
+		int sumEtBinId = sumEtBin( cell_particles, scales[i] );
+		if ( sumEtBinId < 0 ) continue;
+		
+		// the history only carries over if the scaled event stays at the same
+		// R; a scale moving it to a sumEt bin with another R is reclustered
+		if ( fjClusterSeq.get() != 0 && fjClusterSeq->jet_def().R() == rBins_[sumEtBinId] )
+			fjClusterSeqs[i] = fjClusterSeq;
+		else
+			fjClusterSeqs[i] = cluster( cell_particles, sumEtBinId, cache );
+		
+		findTopJets( cell_particles, *fjClusterSeqs[i], scales[i], hardjetsOutput[i] );
+	}
+}
+
+
+//  Sum Et bin of the event, with all momenta scaled by scale
+//  ------------------------------------------------------------
+int CATopJetAlgorithm::sumEtBin( const vector<fastjet::PseudoJet> & cell_particles, double scale ) const
+{
 	// Sum Et of the event
 	double sumEt = 0.;
-	
-	//make a list of input objects ordered by ET and calculate sum et
-	// list of fastjet pseudojet constituents
 	for (unsigned i = 0; i < cell_particles.size(); ++i) {
 		sumEt += cell_particles[i].perp();
 	}
+	sumEt *= scale;
 	
-	// Determine which bin we are in for et clustering
 	int sumEtBinId = -1;
 	for ( unsigned int i = 0; i < sumEtBins_.size(); ++i ) {
 		if ( sumEt > sumEtBins_[i] ) sumEtBinId = i;
 	}
 	if ( verbose_ ) cout << "Using sumEt = " << sumEt << ", bin = " << sumEtBinId << endl;
+	return sumEtBinId;
+}
+
+
+//  Find the top jets in a clustered event, with all momenta scaled by scale
+//  -------------------------------------------------------------------------
+void CATopJetAlgorithm::findTopJets( const vector<fastjet::PseudoJet> & cell_particles, 
+				     const fastjet::ClusterSequence & fjClusterSeq,
+				     double scale,
+				     vector<fastjet::PseudoJet> & hardjetsOutput
+				     ) const
+{
+	// Determine which bin we are in for et clustering
+	int sumEtBinId = sumEtBin( cell_particles, scale );
 	
 	// If the sum et is too low, exit
 	if ( sumEtBinId < 0 ) {    
@@ -78,14 +170,14 @@ void CATopJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles,
 	
 	if ( verbose_ ) cout << "Getting inclusive jets" << endl;
 	// Get the transient inclusive jets
-	vector<fastjet::PseudoJet> inclusiveJets = fjClusterSeq->inclusive_jets(ptMin_);
+	vector<fastjet::PseudoJet> inclusiveJets = fjClusterSeq.inclusive_jets(ptMin_/scale);
 	
 	if ( verbose_ ) cout << "Getting central jets" << endl;
 	// Find the transient central jets
 	vector<fastjet::PseudoJet> centralJets;
 	for (unsigned int i = 0; i < inclusiveJets.size(); i++) {
 		
-		if (inclusiveJets[i].perp() > ptMin_ && fabs(inclusiveJets[i].rapidity()) < centralEtaCut_) {
+		if (inclusiveJets[i].perp()*scale > ptMin_ && fabs(inclusiveJets[i].rapidity()) < centralEtaCut_) {
 			centralJets.push_back(inclusiveJets[i]);
 		}
 	}
@@ -105,10 +197,14 @@ void CATopJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles,
 	  centralJetsEnd = centralJets.end();
 	if ( verbose_ )cout<<"Loop over jets"<<endl;
 	int i=0;
+	// Clustering history of the current jet, walked once and then scanned by
+	// all the decomposition stages below
+	JetSplittingRecord record;
 	for ( ; jetIt != centralJetsEnd; ++jetIt ) {
 		if ( verbose_ )cout<<"\nJet "<<i<<endl;
 		i++;
 		fastjet::PseudoJet localJet = *jetIt;
+		record.reset(fjClusterSeq,localJet);
 		
 		// Get the 4-vector for this jet
 		p4_hardJets.push_back( math::XYZTLorentzVector(localJet.px(), localJet.py(), localJet.pz(), localJet.e() ));
@@ -122,28 +218,40 @@ void CATopJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles,
 		
 		// stage 1:  primary decomposition.  look for when the jet declusters into two hard subjets
 		if ( verbose_ ) cout << "Doing decomposition 1" << endl;
-		fastjet::PseudoJet ja, jb;
+		int ia = -1, ib = -1;
 		vector<fastjet::PseudoJet> leftovers1;
-		bool hardBreak1 = decomposeJet(localJet,*fjClusterSeq,cell_particles,ptHard,nCellMin,deltarcut,ja,jb,leftovers1);
+		bool hardBreak1 = decomposeJet(record,record.root(),cell_particles,scale,ptHard,nCellMin,deltarcut,ia,ib,leftovers1);
 		leftoversAll.insert(leftoversAll.end(),leftovers1.begin(),leftovers1.end());
 		
 		// stage 2:  secondary decomposition.  look for when the hard subjets found above further decluster into two hard sub-subjets
 		//
 		// ja -> jaa+jab ?
 		if ( verbose_ ) cout << "Doing decomposition 2. ja->jaa+jab?" << endl;
-		fastjet::PseudoJet jaa, jab;
+		int iaa = -1, iab = -1;
 		vector<fastjet::PseudoJet> leftovers2a;
 		bool hardBreak2a = false;
-		if (hardBreak1)  hardBreak2a = decomposeJet(ja,*fjClusterSeq,cell_particles,ptHard,nCellMin,deltarcut,jaa,jab,leftovers2a);
+		if (hardBreak1)  hardBreak2a = decomposeJet(record,ia,cell_particles,scale,ptHard,nCellMin,deltarcut,iaa,iab,leftovers2a);
 		leftoversAll.insert(leftoversAll.end(),leftovers2a.begin(),leftovers2a.end());
 		// jb -> jba+jbb ?
 		if ( verbose_ ) cout << "Doing decomposition 2. ja->jba+jbb?" << endl;
-		fastjet::PseudoJet jba, jbb;
+		int iba = -1, ibb = -1;
 		vector<fastjet::PseudoJet> leftovers2b;
 		bool hardBreak2b = false;
-		if (hardBreak1)  hardBreak2b = decomposeJet(jb,*fjClusterSeq,cell_particles,ptHard,nCellMin,deltarcut,jba,jbb,leftovers2b);
+		if (hardBreak1)  hardBreak2b = decomposeJet(record,ib,cell_particles,scale,ptHard,nCellMin,deltarcut,iba,ibb,leftovers2b);
 		leftoversAll.insert(leftoversAll.end(),leftovers2b.begin(),leftovers2b.end());
 		
+		// the hard subjets found above, as PseudoJets
+		fastjet::PseudoJet ja  = (ia <0) ? blankJet : record.pseudoJet(ia);
+		fastjet::PseudoJet jb  = (ib <0) ? blankJet : record.pseudoJet(ib);
+		fastjet::PseudoJet jaa = (iaa<0) ? blankJet : record.pseudoJet(iaa);
+		fastjet::PseudoJet jab = (iab<0) ? blankJet : record.pseudoJet(iab);
+		fastjet::PseudoJet jba = (iba<0) ? blankJet : record.pseudoJet(iba);
+		fastjet::PseudoJet jbb = (ibb<0) ? blankJet : record.pseudoJet(ibb);
+		if ( scale != 1. ) {
+			localJet *= scale;
+			ja *= scale; jb *= scale; jaa *= scale; jab *= scale; jba *= scale; jbb *= scale;
+		}
+		
 		// NOTE:  it might be good to consider some checks for whether these subjets can be further decomposed.  e.g., the above procedure leaves
 		//        open the possibility of "subjets" that actually consist of two or more distinct hard clusters.  however, this kind of thing
 		//        is a rarity for the simulations so far considered.
@@ -237,7 +345,7 @@ void CATopJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles,
 		// Use new fastjet functionality to create a Pseudojet from constituents
 		fastjet::PseudoJet candidate = join(hardSubjets);
 		// Reset the jet's 4-vector to the "ungroomed" value
-		candidate.reset_momentum( jetIt->px(), jetIt->py(), jetIt->pz(), jetIt->e() );
+		candidate.reset_momentum( localJet.px(), localJet.py(), localJet.pz(), localJet.e() );
 
 		if ( verbose_ ) {
 		  std::cout << "Final top-jet candidate: (Pt,Y,Phi,M) = (" 
@@ -286,36 +394,43 @@ bool CATopJetAlgorithm::adjacentCells(const fastjet::PseudoJet & jet1, const fas
 
 
 //-------------------------------------------------------------------------
-// attempt to decompose a jet into "hard" subjets, where hardness is set by ptHard
+// attempt to decompose a jet into "hard" subjets, where hardness is set by ptHard.
+// theJet, ja and jb are indices into the jet's JetSplittingRecord. ptHard is
+// in unscaled units, scale only enters the pt-dependent adjacency cut.
 //
-bool CATopJetAlgorithm::decomposeJet(const fastjet::PseudoJet & theJet, 
-									 const fastjet::ClusterSequence & theClusterSequence, 
+bool CATopJetAlgorithm::decomposeJet(const JetSplittingRecord & theRecord, 
+									 int theJet, 
 									 const vector<fastjet::PseudoJet> & cell_particles,
+									 double scale,
 									 double ptHard, double nCellMin, double deltarcut,
-									 fastjet::PseudoJet & ja, fastjet::PseudoJet & jb, 
+									 int & ja, int & jb, 
 									 vector<fastjet::PseudoJet> & leftovers) const {
 	
 	bool goodBreak;
-	fastjet::PseudoJet j = theJet;
-	double InputObjectPt = j.perp();
+	int j = theJet;
+	double InputObjectPt = theRecord[j].pt*scale;
 	if ( verbose_ )cout<<"Input Object Pt = "<<InputObjectPt<<endl;
 	if ( verbose_ )cout<<"ptHard = "<<ptHard<<endl;
 	leftovers.clear();
 	if ( verbose_ )cout<<"start while loop"<<endl;
 	
 	while (1) {                                                      // watch out for infinite loop!
-		goodBreak = theClusterSequence.has_parents(j,ja,jb);
+		goodBreak = theRecord.hasParents(j);
 		if (!goodBreak){
 			if ( verbose_ )cout<<"bad break. this is one cell. can't decluster anymore."<<endl;
 			break;         // this is one cell, can't decluster anymore
 		}
+		ja = theRecord[j].parent1;
+		jb = theRecord[j].parent2;
+		const JetSplittingRecord::Node & na = theRecord[ja];
+		const JetSplittingRecord::Node & nb = theRecord[jb];
 		
-		if ( verbose_ )cout<<"good break. ja Pt = "<<ja.perp()<<" jb Pt = "<<jb.perp()<<endl;
+		if ( verbose_ )cout<<"good break. ja Pt = "<<na.pt<<" jb Pt = "<<nb.pt<<endl;
 		
 		/// Adjacency Requirement ///
 		
 		// check if clusters are adjacent using a constant deltar adjacency.
-		double clusters_deltar=fabs(ja.eta()-jb.eta())+fabs(deltaPhi(ja.phi(),jb.phi()));
+		double clusters_deltar=fabs(na.eta-nb.eta)+fabs(deltaPhi(na.phi,nb.phi));
 		
 		if ( verbose_  && useAdjacency_ ==1)cout<<"clusters_deltar = "<<clusters_deltar<<endl;
 		if ( verbose_  && useAdjacency_ ==1)cout<<"deltar cut = "<<deltarcut<<endl;
@@ -326,7 +441,7 @@ bool CATopJetAlgorithm::decomposeJet(const fastjet::PseudoJet & theJet,
 		} 
 		
 		// Check if clusters are adjacent using a DeltaR adjacency which is a function of pT.
-		double clusters_deltaR=deltaR( ja.rapidity(), ja.phi(), jb.rapidity(), jb.phi() );
+		double clusters_deltaR=deltaR( na.rapidity, na.phi, nb.rapidity, nb.phi );
 		
 		if ( verbose_  && useAdjacency_ ==2)cout<<"clusters_deltaR = "<<clusters_deltaR<<endl;
 		if ( verbose_  && useAdjacency_ ==2)cout<<"0.4-0.0004*InputObjectPt = "<<0.4-0.0004*InputObjectPt<<endl;
@@ -338,7 +453,7 @@ bool CATopJetAlgorithm::decomposeJet(const fastjet::PseudoJet & theJet,
 		} 
 
 		// Check if clusters are adjacent in the calorimeter. 
-		if ( useAdjacency_==3 &&  adjacentCells(ja,jb,cell_particles,theClusterSequence,nCellMin) ){                  
+		if ( useAdjacency_==3 &&  adjacentCells(theRecord.pseudoJet(ja),theRecord.pseudoJet(jb),cell_particles,theRecord.clusterSequence(),nCellMin) ){                  
 			if ( verbose_ )cout<<"clusters too close in the calorimeter. calorimeter adj. break."<<endl;
 			break;         // the clusters are "adjacent" in the calorimeter => shouldn't have decomposed
 		}
@@ -349,34 +464,34 @@ bool CATopJetAlgorithm::decomposeJet(const fastjet::PseudoJet & theJet,
 		
 		if ( verbose_ )cout<<"ptHard = "<<ptHard<<endl;
 		
-		if (ja.perp() < ptHard && jb.perp() < ptHard){
+		if (na.pt < ptHard && nb.pt < ptHard){
 			if ( verbose_ )cout<<"two soft clusters. dead end"<<endl;
 			break;         // broke into two soft clusters, dead end
 		}
 		
-		if (ja.perp() > ptHard && jb.perp() > ptHard){
+		if (na.pt > ptHard && nb.pt > ptHard){
 			if ( verbose_ )cout<<"two hard clusters. done"<<endl;
 			return true;   // broke into two hard clusters, we're done!
 		}
 		
-		else if (ja.perp() > jb.perp()) {                              // broke into one hard and one soft, ditch the soft one and try again
+		else if (na.pt > nb.pt) {                              // broke into one hard and one soft, ditch the soft one and try again
 			if ( verbose_ )cout<<"ja hard jb soft. try to split hard. j = ja"<<endl; 
 			j = ja;
-			vector<fastjet::PseudoJet> particles = theClusterSequence.constituents(jb);
+			vector<fastjet::PseudoJet> particles = theRecord.clusterSequence().constituents(theRecord.pseudoJet(jb));
 			leftovers.insert(leftovers.end(),particles.begin(),particles.end());
 		}
 		else {
 			if ( verbose_ )cout<<"ja hard jb soft. try to split hard. j = jb"<<endl; 
 			j = jb;
-			vector<fastjet::PseudoJet> particles = theClusterSequence.constituents(ja);
+			vector<fastjet::PseudoJet> particles = theRecord.clusterSequence().constituents(theRecord.pseudoJet(ja));
 			leftovers.insert(leftovers.end(),particles.begin(),particles.end());
 		}
 	}
 	
 	if ( verbose_ )cout<<"did not decluster."<<endl;  // did not decluster into hard subjets
 	
-	ja.reset(0,0,0,0);
-	jb.reset(0,0,0,0);
+	ja = -1;
+	jb = -1;
 	leftovers.clear();
 	return false;
 }
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// ClusterSequenceCache
+// --------------------
+//
+// see RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h"
+
+#include <fastjet/ClusterSequenceArea.hh>
+
+#include <boost/functional/hash.hpp>
+
+#include <functional>
+#include <sstream>
+
+
+using namespace std;
+
+
+namespace {
+  tbb::mutex ghostRandomMutex_;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+ClusterSequenceCache::ClusterSequenceCache()
+  : nHits_(0)
+  , nMisses_(0)
+  , nEvents_(0)
+  , used_(false)
+{
+}
+
+
+//______________________________________________________________________________
+ClusterSequenceCache::~ClusterSequenceCache()
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+ClusterSequenceCache::ClusterSequencePtr
+ClusterSequenceCache::get(const vector<fastjet::PseudoJet>& inputs,
+			  const fastjet::JetDefinition&     jetDef,
+			  const fastjet::AreaDefinition*    areaDef)
+{
+  used_ = true;
+
+  Key k = key(inputs,jetDef,(0!=areaDef) ? areaDef->description() : string());
+
+  map<Key,ClusterSequencePtr>::const_iterator it = sequences_.find(k);
+  if (it!=sequences_.end()) {
+    nHits_++;
+    return it->second;
+  }
+
+  nMisses_++;
+  ClusterSequencePtr cs = cluster(inputs,jetDef,areaDef);
+  sequences_[k] = cs;
+  return cs;
+}
+
+
+//______________________________________________________________________________
+ClusterSequenceCache::ClusterSequencePtr
+ClusterSequenceCache::get(const vector<fastjet::PseudoJet>& inputs,
+			  const fastjet::JetDefinition&     jetDef,
+			  const GhostTemplatePool&          ghosts)
+{
+  used_ = true;
+
+  unsigned iTemplate = ghosts.select(inputs);
+  Key k = key(inputs,jetDef,ghosts.description(iTemplate));
+
+  map<Key,ClusterSequencePtr>::const_iterator it = sequences_.find(k);
+  if (it!=sequences_.end()) {
+    nHits_++;
+    return it->second;
+  }
+
+  nMisses_++;
+  ClusterSequencePtr cs = ghosts.cluster(inputs,jetDef,iTemplate);
+  sequences_[k] = cs;
+  return cs;
+}
+
+
+//______________________________________________________________________________
+void ClusterSequenceCache::clear()
+{
+  if (used_) nEvents_++;
+  used_ = false;
+  sequences_.clear();
+}
+
+
+//______________________________________________________________________________
+ClusterSequenceCache::ClusterSequencePtr
+ClusterSequenceCache::cluster(const vector<fastjet::PseudoJet>& inputs,
+			      const fastjet::JetDefinition&     jetDef,
+			      const fastjet::AreaDefinition*    areaDef)
+{
+  if (0==areaDef)
+    return ClusterSequencePtr(new fastjet::ClusterSequence(inputs,jetDef));
+  tbb::mutex::scoped_lock lock;
+  if (areaDef->area_type()!=fastjet::voronoi_area) lock.acquire(ghostRandomMutex_);
+  return ClusterSequencePtr(new fastjet::ClusterSequenceArea(inputs,jetDef,*areaDef));
+}
+
+
+//______________________________________________________________________________
+tbb::mutex& ClusterSequenceCache::ghostRandomMutex()
+{
+  return ghostRandomMutex_;
+}
+
+
+//______________________________________________________________________________
+string ClusterSequenceCache::summary() const
+{
+  unsigned nRequests = nHits_+nMisses_;
+  double   hitRate   = (nRequests>0) ? nHits_/(double)nRequests : 0;
+  std::stringstream ss;
+  ss<<"************************************************************\n"
+    <<"* ClusterSequenceCache SUMMARY:\n"
+    <<"************************************************************\n"
+    <<"nevents  = "<<nEvents_<<endl
+    <<"nhits    = "<<nHits_<<endl
+    <<"nmisses  = "<<nMisses_<<endl
+    <<"hit rate = "<<hitRate<<endl
+    <<"************************************************************\n";
+  return ss.str();
+}
+
+
+//______________________________________________________________________________
+ClusterSequenceCache::Key
+ClusterSequenceCache::key(const vector<fastjet::PseudoJet>& inputs,
+			  const fastjet::JetDefinition&     jetDef,
+			  const string&                     areaDef)
+{
+  Key k;
+  k.inputs      = inputs.empty() ? 0 : &inputs.front();
+  k.nInputs     = inputs.size();
+  k.fingerprint = fingerprint(inputs);
+  k.jetDef      = jetDef.description();
+  k.areaDef     = areaDef;
+  return k;
+}
+
+
+//______________________________________________________________________________
+size_t ClusterSequenceCache::fingerprint(const vector<fastjet::PseudoJet>& inputs)
+{
+  size_t seed(0);
+  for (size_t i=0;i<inputs.size();i++) {
+    const fastjet::PseudoJet& pj = inputs[i];
+    boost::hash_combine(seed,pj.px());
+    boost::hash_combine(seed,pj.py());
+    boost::hash_combine(seed,pj.pz());
+    boost::hash_combine(seed,pj.E());
+    boost::hash_combine(seed,pj.user_index());
+  }
+  return seed;
+}
+
+
+//______________________________________________________________________________
+bool ClusterSequenceCache::Key::operator<(const Key& other) const
+{
+  if (inputs     !=other.inputs)
+    return std::less<const fastjet::PseudoJet*>()(inputs,other.inputs);
+  if (nInputs    !=other.nInputs)     return nInputs    <other.nInputs;
+  if (fingerprint!=other.fingerprint) return fingerprint<other.fingerprint;
+  if (jetDef     !=other.jetDef)      return jetDef     <other.jetDef;
+  return areaDef<other.areaDef;
+}
@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// CompoundJetWriter
+// -----------------
+//
+// see RecoJets/JetAlgorithms/interface/CompoundJetWriter.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/CompoundJetWriter.h"
+
+#include "DataFormats/Common/interface/Ptr.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <memory>
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+CompoundJetWriter::CompoundJetWriter(const string& subJetInstanceName)
+  : subJetInstanceName_(subJetInstanceName)
+{
+}
+
+
+//______________________________________________________________________________
+CompoundJetWriter::~CompoundJetWriter()
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+void CompoundJetWriter::fillSubJets(const CompoundPseudoJetCollection&     jets,
+				    const vector<reco::CandidatePtr>&      inputs,
+				    reco::BasicJetCollection&              subJets) const
+{
+  subJets.reserve(subJets.size()+jets.nSubJets());
+
+  reco::Jet::Constituents constituents;
+  for (unsigned j=0;j<jets.nSubJets();j++) {
+    const int* indices = jets.constituents(j);
+    unsigned   n       = jets.nConstituents(j);
+    constituents.clear();
+    constituents.reserve(n);
+    for (unsigned k=0;k<n;k++) {
+      unsigned index = indices[k];
+      if (index>=inputs.size())
+	throw cms::Exception("CompoundJetWriter")
+	  <<"constituent index "<<index<<" out of range, "
+	  <<inputs.size()<<" inputs\n";
+      constituents.push_back(inputs[index]);
+    }
+    const CompoundPseudoJetCollection::FourVector& p4 = jets.subJetP4(j);
+    subJets.push_back(makeJet(p4.px,p4.py,p4.pz,p4.e,p4.area,constituents));
+  }
+}
+
+
+//______________________________________________________________________________
+void CompoundJetWriter::fillSubJets(const vector<CompoundPseudoJet>&  jets,
+				    const vector<reco::CandidatePtr>& inputs,
+				    reco::BasicJetCollection&         subJets) const
+{
+  unsigned nSubJets(0);
+  for (unsigned i=0;i<jets.size();i++) nSubJets += jets[i].subjets().size();
+  subJets.reserve(subJets.size()+nSubJets);
+
+  reco::Jet::Constituents constituents;
+  for (unsigned i=0;i<jets.size();i++) {
+    const vector<CompoundPseudoSubJet>& subjets = jets[i].subjets();
+    for (unsigned j=0;j<subjets.size();j++) {
+      const vector<int>& indices = subjets[j].constituents();
+      constituents.clear();
+      constituents.reserve(indices.size());
+      for (unsigned k=0;k<indices.size();k++) {
+	unsigned index = indices[k];
+	if (index>=inputs.size())
+	  throw cms::Exception("CompoundJetWriter")
+	    <<"constituent index "<<index<<" out of range, "
+	    <<inputs.size()<<" inputs\n";
+	constituents.push_back(inputs[index]);
+      }
+      const fastjet::PseudoJet& subjet = subjets[j].subjet();
+      subJets.push_back(makeJet(subjet.px(),subjet.py(),subjet.pz(),subjet.e(),
+				subjets[j].subjetArea(),constituents));
+    }
+  }
+}
+
+
+//______________________________________________________________________________
+void CompoundJetWriter::fillFatJets(const CompoundPseudoJetCollection&                 jets,
+				    const edm::OrphanHandle<reco::BasicJetCollection>& subJetHandle,
+				    reco::BasicJetCollection&                          fatJets,
+				    unsigned                                           subJetOffset) const
+{
+  fatJets.reserve(fatJets.size()+jets.size());
+
+  reco::Jet::Constituents constituents;
+  for (unsigned i=0;i<jets.size();i++) {
+    constituents.clear();
+    constituents.reserve(jets.nSubJets(i));
+    for (unsigned j=jets.subJetBegin(i);j<jets.subJetEnd(i);j++)
+      constituents.push_back(reco::CandidatePtr(subJetHandle,subJetOffset+j,false));
+    const CompoundPseudoJetCollection::FourVector& p4 = jets.hardJetP4(i);
+    fatJets.push_back(makeJet(p4.px,p4.py,p4.pz,p4.e,p4.area,constituents));
+  }
+}
+
+
+//______________________________________________________________________________
+void CompoundJetWriter::fillFatJets(const vector<CompoundPseudoJet>&                   jets,
+				    const edm::OrphanHandle<reco::BasicJetCollection>& subJetHandle,
+				    reco::BasicJetCollection&                          fatJets,
+				    unsigned                                           subJetOffset) const
+{
+  fatJets.reserve(fatJets.size()+jets.size());
+
+  reco::Jet::Constituents constituents;
+  unsigned iSubJet(subJetOffset);
+  for (unsigned i=0;i<jets.size();i++) {
+    unsigned nSubJets = jets[i].subjets().size();
+    constituents.clear();
+    constituents.reserve(nSubJets);
+    for (unsigned j=0;j<nSubJets;j++)
+      constituents.push_back(reco::CandidatePtr(subJetHandle,iSubJet++,false));
+    const fastjet::PseudoJet& hardJet = jets[i].hardJet();
+    fatJets.push_back(makeJet(hardJet.px(),hardJet.py(),hardJet.pz(),hardJet.e(),
+			      jets[i].hardJetArea(),constituents));
+  }
+}
+
+
+//______________________________________________________________________________
+void CompoundJetWriter::put(edm::Event&                        iEvent,
+			    const CompoundPseudoJetCollection& jets,
+			    const vector<reco::CandidatePtr>&  inputs) const
+{
+  auto_ptr<reco::BasicJetCollection> subJets(new reco::BasicJetCollection());
+  fillSubJets(jets,inputs,*subJets);
+  edm::OrphanHandle<reco::BasicJetCollection> subJetHandle =
+    iEvent.put(subJets,subJetInstanceName_);
+
+  auto_ptr<reco::BasicJetCollection> fatJets(new reco::BasicJetCollection());
+  fillFatJets(jets,subJetHandle,*fatJets);
+  iEvent.put(fatJets);
+}
+
+
+//______________________________________________________________________________
+void CompoundJetWriter::put(edm::Event&                       iEvent,
+			    const vector<CompoundPseudoJet>&  jets,
+			    const vector<reco::CandidatePtr>& inputs) const
+{
+  auto_ptr<reco::BasicJetCollection> subJets(new reco::BasicJetCollection());
+  fillSubJets(jets,inputs,*subJets);
+  edm::OrphanHandle<reco::BasicJetCollection> subJetHandle =
+    iEvent.put(subJets,subJetInstanceName_);
+
+  auto_ptr<reco::BasicJetCollection> fatJets(new reco::BasicJetCollection());
+  fillFatJets(jets,subJetHandle,*fatJets);
+  iEvent.put(fatJets);
+}
+
+
+//______________________________________________________________________________
+reco::BasicJet CompoundJetWriter::makeJet(double px,double py,double pz,double e,
+					  double area,
+					  const reco::Jet::Constituents& constituents)
+{
+  reco::Particle::Point point(0,0,0);
+  reco::BasicJet jet(reco::Particle::LorentzVector(px,py,pz,e),point,constituents);
+  jet.setJetArea(area);
+  return jet;
+}
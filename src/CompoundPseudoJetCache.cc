@@ -0,0 +1,410 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// CompoundPseudoJetCache
+// ----------------------
+//
+// see RecoJets/JetAlgorithms/interface/CompoundPseudoJetCache.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCache.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <cerrno>
+
+
+using namespace std;
+using namespace CompoundPseudoJetCache;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// CompoundPseudoJetCacheWriter
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+CompoundPseudoJetCacheWriter::CompoundPseudoJetCacheWriter(const string& fileName)
+  : fileName_(fileName)
+  , file_(0)
+  , nEvents_(0)
+{
+  file_ = std::fopen(fileName_.c_str(),"wb");
+  if (0==file_)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Can't open "<<fileName_<<" for writing: "<<strerror(errno)<<"\n";
+
+  FileHeader header;
+  header.magic     = kMagic;
+  header.version   = kVersion;
+  header.byteOrder = kByteOrder;
+  header.reserved  = 0;
+  if (std::fwrite(&header,sizeof(header),1,file_)!=1)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Failed to write header to "<<fileName_<<"\n";
+}
+
+
+//______________________________________________________________________________
+CompoundPseudoJetCacheWriter::~CompoundPseudoJetCacheWriter()
+{
+  if (0!=file_) std::fclose(file_);
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::write(uint32_t run,uint32_t lumi,uint64_t event,
+					 const CompoundPseudoJetCollection& jets)
+{
+  jets_.clear(); subJetBegins_.clear(); subJets_.clear();
+  byteBegins_.clear(); bytes_.clear();
+
+  for (unsigned i=0;i<jets.size();i++) {
+    const CompoundPseudoJetCollection::FourVector& p4 = jets.hardJetP4(i);
+    putP4(p4.px,p4.py,p4.pz,p4.e,p4.area);
+    subJetBegins_.push_back(subJets_.size());
+    for (unsigned j=jets.subJetBegin(i);j<jets.subJetEnd(i);j++) {
+      const CompoundPseudoJetCollection::FourVector& sub = jets.subJetP4(j);
+      byteBegins_.push_back(bytes_.size());
+      subJets_.push_back(PackedP4());
+      PackedP4& packed = subJets_.back();
+      packed.px = sub.px; packed.py = sub.py; packed.pz = sub.pz;
+      packed.e  = sub.e;  packed.area = sub.area;
+      const int* constituents = jets.constituents(j);
+      for (unsigned k=0;k<jets.nConstituents(j);k++) putVarint(constituents[k]);
+    }
+  }
+
+  flush(run,lumi,event,jets.size(),subJets_.size());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::write(uint32_t run,uint32_t lumi,uint64_t event,
+					 const vector<CompoundPseudoJet>& jets)
+{
+  jets_.clear(); subJetBegins_.clear(); subJets_.clear();
+  byteBegins_.clear(); bytes_.clear();
+
+  for (unsigned i=0;i<jets.size();i++) {
+    const fastjet::PseudoJet& hardJet = jets[i].hardJet();
+    putP4(hardJet.px(),hardJet.py(),hardJet.pz(),hardJet.e(),jets[i].hardJetArea());
+    subJetBegins_.push_back(subJets_.size());
+    const vector<CompoundPseudoSubJet>& subJets = jets[i].subjets();
+    for (unsigned j=0;j<subJets.size();j++) {
+      const fastjet::PseudoJet& sub = subJets[j].subjet();
+      byteBegins_.push_back(bytes_.size());
+      subJets_.push_back(PackedP4());
+      PackedP4& packed = subJets_.back();
+      packed.px = sub.px(); packed.py = sub.py(); packed.pz = sub.pz();
+      packed.e  = sub.e();  packed.area = subJets[j].subjetArea();
+      const vector<int>& constituents = subJets[j].constituents();
+      for (unsigned k=0;k<constituents.size();k++) putVarint(constituents[k]);
+    }
+  }
+
+  flush(run,lumi,event,jets.size(),subJets_.size());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::close()
+{
+  if (0==file_) return;
+  int status = std::fclose(file_);
+  file_ = 0;
+  if (status!=0)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Failed to close "<<fileName_<<"\n";
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::putP4(double px,double py,double pz,double e,
+					 double area)
+{
+  jets_.push_back(PackedP4());
+  PackedP4& packed = jets_.back();
+  packed.px = px; packed.py = py; packed.pz = pz; packed.e = e; packed.area = area;
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::putWord(uint32_t word)
+{
+  const char* p = reinterpret_cast<const char*>(&word);
+  record_.insert(record_.end(),p,p+sizeof(word));
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::putVarint(uint32_t value)
+{
+  while (value>=0x80) {
+    bytes_.push_back(static_cast<uint8_t>(value|0x80));
+    value >>= 7;
+  }
+  bytes_.push_back(static_cast<uint8_t>(value));
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheWriter::flush(uint32_t run,uint32_t lumi,uint64_t event,
+					 uint32_t nJets,uint32_t nSubJets)
+{
+  if (0==file_)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Writing to closed file "<<fileName_<<"\n";
+
+  subJetBegins_.push_back(nSubJets);
+  byteBegins_.push_back(bytes_.size());
+  uint32_t nBytes  = bytes_.size();
+  uint32_t padding = (4-nBytes%4)%4;
+
+  RecordHeader header;
+  header.size      = sizeof(RecordHeader)
+    + nJets*sizeof(PackedP4)    + (nJets+1)*sizeof(uint32_t)
+    + nSubJets*sizeof(PackedP4) + (nSubJets+1)*sizeof(uint32_t)
+    + nBytes+padding;
+  header.run       = run;
+  header.lumi      = lumi;
+  header.eventLow  = static_cast<uint32_t>(event&0xffffffff);
+  header.eventHigh = static_cast<uint32_t>(event>>32);
+  header.nJets     = nJets;
+  header.nSubJets  = nSubJets;
+  header.nBytes    = nBytes;
+
+  record_.clear();
+  record_.reserve(header.size);
+  const char* p = reinterpret_cast<const char*>(&header);
+  record_.insert(record_.end(),p,p+sizeof(header));
+  if (nJets>0) {
+    p = reinterpret_cast<const char*>(&jets_[0]);
+    record_.insert(record_.end(),p,p+nJets*sizeof(PackedP4));
+  }
+  for (unsigned i=0;i<subJetBegins_.size();i++) putWord(subJetBegins_[i]);
+  if (nSubJets>0) {
+    p = reinterpret_cast<const char*>(&subJets_[0]);
+    record_.insert(record_.end(),p,p+nSubJets*sizeof(PackedP4));
+  }
+  for (unsigned j=0;j<byteBegins_.size();j++) putWord(byteBegins_[j]);
+  record_.insert(record_.end(),bytes_.begin(),bytes_.end());
+  record_.insert(record_.end(),padding,0);
+
+  if (std::fwrite(&record_[0],record_.size(),1,file_)!=1)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Failed to write event "<<event<<" to "<<fileName_<<"\n";
+  nEvents_++;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// CompoundPseudoJetCacheReader
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+CompoundPseudoJetCacheReader::CompoundPseudoJetCacheReader(const string& fileName)
+  : fileName_(fileName)
+  , fd_(-1)
+  , data_(0)
+  , size_(0)
+{
+  fd_ = ::open(fileName_.c_str(),O_RDONLY);
+  if (fd_<0)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Can't open "<<fileName_<<": "<<strerror(errno)<<"\n";
+
+  struct stat status;
+  if (::fstat(fd_,&status)!=0) {
+    ::close(fd_);
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Can't stat "<<fileName_<<": "<<strerror(errno)<<"\n";
+  }
+  size_ = status.st_size;
+
+  if (size_>0) {
+    void* data = ::mmap(0,size_,PROT_READ,MAP_SHARED,fd_,0);
+    if (data==MAP_FAILED) {
+      ::close(fd_);
+      throw cms::Exception("CompoundPseudoJetCache")
+	<<"Can't map "<<fileName_<<": "<<strerror(errno)<<"\n";
+    }
+    data_ = static_cast<const char*>(data);
+  }
+
+  try {
+    index();
+  }
+  catch (...) {
+    if (0!=data_) ::munmap(const_cast<char*>(data_),size_);
+    ::close(fd_);
+    throw;
+  }
+}
+
+
+//______________________________________________________________________________
+CompoundPseudoJetCacheReader::~CompoundPseudoJetCacheReader()
+{
+  if (0!=data_) ::munmap(const_cast<char*>(data_),size_);
+  if (fd_>=0)   ::close(fd_);
+}
+
+
+//______________________________________________________________________________
+CompoundPseudoJetCacheReader::EventView
+CompoundPseudoJetCacheReader::event(unsigned i) const
+{
+  if (i>=records_.size())
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<"Event "<<i<<" requested, but "<<fileName_<<" has "
+      <<records_.size()<<" events\n";
+  return records_[i];
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheReader::index()
+{
+  if (size_<sizeof(FileHeader))
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<fileName_<<" is too short to be a CompoundPseudoJet cache\n";
+
+  const FileHeader* header = reinterpret_cast<const FileHeader*>(data_);
+  if (header->magic!=kMagic)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<fileName_<<" is not a CompoundPseudoJet cache\n";
+  if (header->byteOrder!=kByteOrder)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<fileName_<<" was written with a different byte order\n";
+  if (header->version!=kVersion)
+    throw cms::Exception("CompoundPseudoJetCache")
+      <<fileName_<<" has format version "<<header->version
+      <<", expected "<<kVersion<<"\n";
+
+  size_t offset = sizeof(FileHeader);
+  while (offset<size_) {
+    if (size_-offset<sizeof(RecordHeader))
+      throw cms::Exception("CompoundPseudoJetCache")
+	<<fileName_<<": truncated record at byte "<<offset<<"\n";
+
+    const RecordHeader* record = reinterpret_cast<const RecordHeader*>(data_+offset);
+    uint64_t expected = sizeof(RecordHeader)
+      + (uint64_t)record->nJets*sizeof(PackedP4)    + ((uint64_t)record->nJets+1)*sizeof(uint32_t)
+      + (uint64_t)record->nSubJets*sizeof(PackedP4) + ((uint64_t)record->nSubJets+1)*sizeof(uint32_t)
+      + record->nBytes + (4-record->nBytes%4)%4;
+    if (record->size!=expected||record->size>size_-offset)
+      throw cms::Exception("CompoundPseudoJetCache")
+	<<fileName_<<": corrupt record at byte "<<offset<<"\n";
+
+    EventView view;
+    const char* p = data_+offset;
+    view.header_       = record;                                    p += sizeof(RecordHeader);
+    view.jets_         = reinterpret_cast<const PackedP4*>(p);      p += record->nJets*sizeof(PackedP4);
+    view.subJetBegins_ = reinterpret_cast<const uint32_t*>(p);      p += (record->nJets+1)*sizeof(uint32_t);
+    view.subJets_      = reinterpret_cast<const PackedP4*>(p);      p += record->nSubJets*sizeof(PackedP4);
+    view.byteBegins_   = reinterpret_cast<const uint32_t*>(p);      p += (record->nSubJets+1)*sizeof(uint32_t);
+    view.bytes_        = reinterpret_cast<const uint8_t*>(p);
+
+    // the accessors index with these offsets without further checks
+    if (!validOffsets(view.subJetBegins_,record->nJets,record->nSubJets)||
+	!validOffsets(view.byteBegins_,record->nSubJets,record->nBytes))
+      throw cms::Exception("CompoundPseudoJetCache")
+	<<fileName_<<": inconsistent offsets in record at byte "<<offset<<"\n";
+
+    records_.push_back(view);
+    offset += record->size;
+  }
+}
+
+
+//______________________________________________________________________________
+bool CompoundPseudoJetCacheReader::validOffsets(const uint32_t* begins,uint32_t n,
+						uint32_t total)
+{
+  if (begins[0]!=0||begins[n]!=total) return false;
+  for (uint32_t i=0;i<n;i++) if (begins[i]>begins[i+1]) return false;
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// CompoundPseudoJetCacheReader::EventView
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+uint64_t CompoundPseudoJetCacheReader::EventView::event() const
+{
+  return ((uint64_t)header_->eventHigh<<32)|header_->eventLow;
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheReader::EventView::constituents(unsigned j,
+							   vector<int>& indices) const
+{
+  indices.clear();
+  const uint8_t* p   = bytes_+byteBegins_[j];
+  const uint8_t* end = bytes_+byteBegins_[j+1];
+  while (p<end) {
+    // a 32 bit value takes at most 5 bytes, the last one not continued
+    // and carrying only the upper 4 bits
+    uint32_t value(0);
+    unsigned shift(0);
+    uint8_t  byte(0x80);
+    bool     overflow(false);
+    while (p<end&&shift<=28) {
+      byte = *p++;
+      if (shift==28&&(byte&0x70)!=0) overflow = true;
+      value |= (uint32_t)(byte&0x7f)<<shift;
+      shift += 7;
+      if ((byte&0x80)==0) break;
+    }
+    if ((byte&0x80)!=0||overflow)
+      throw cms::Exception("CompoundPseudoJetCache")
+	<<"corrupt constituent index in subjet "<<j<<" of event "<<event()<<"\n";
+    indices.push_back(value);
+  }
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheReader::EventView::fill(CompoundPseudoJetCollection& jets) const
+{
+  vector<int> indices;
+  for (unsigned i=0;i<size();i++) {
+    const PackedP4& p4 = jets_[i];
+    jets.addJet(fastjet::PseudoJet(p4.px,p4.py,p4.pz,p4.e),p4.area);
+    for (unsigned j=subJetBegin(i);j<subJetEnd(i);j++) {
+      const PackedP4& sub = subJets_[j];
+      jets.addSubJet(fastjet::PseudoJet(sub.px,sub.py,sub.pz,sub.e),sub.area);
+      constituents(j,indices);
+      jets.addConstituents(indices);
+    }
+  }
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCacheReader::EventView::fill(vector<CompoundPseudoJet>& jets) const
+{
+  vector<int> indices;
+  for (unsigned i=0;i<size();i++) {
+    vector<CompoundPseudoSubJet> subJets;
+    for (unsigned j=subJetBegin(i);j<subJetEnd(i);j++) {
+      const PackedP4& sub = subJets_[j];
+      constituents(j,indices);
+      subJets.push_back(CompoundPseudoSubJet(fastjet::PseudoJet(sub.px,sub.py,sub.pz,sub.e),
+					     sub.area,indices));
+    }
+    const PackedP4& p4 = jets_[i];
+    jets.push_back(CompoundPseudoJet(fastjet::PseudoJet(p4.px,p4.py,p4.pz,p4.e),
+				     p4.area,subJets));
+  }
+}
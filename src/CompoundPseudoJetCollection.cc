@@ -0,0 +1,219 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// CompoundPseudoJetCollection
+// ---------------------------
+//
+// see RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::clear()
+{
+  hardJets_.clear();
+  hardJetP4s_.clear();
+  hardJetAreaHist_.clear();
+  subJetBegins_.clear();
+  subJets_.clear();
+  subJetP4s_.clear();
+  subJetAreaHist_.clear();
+  constituentBegins_.clear();
+  constituents_.clear();
+  owners_.clear();
+  areaSeqOwner_.reset();
+  areaSeq_ = 0;
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::setAreaSequence(const boost::shared_ptr<fastjet::ClusterSequence>& cs)
+{
+  if (cs.get()==areaSeqOwner_.get()) return;
+  // the sequence would outlive the algorithm, which FourVectors storage avoids
+  if (storage_==FourVectors&&0!=cs.get())
+    throw cms::Exception("LogicError")
+      <<"CompoundPseudoJetCollection: lazy areas require PseudoJets storage\n";
+  // pending areas of jets from the previous sequence are computed now
+  for (unsigned i=0;i<hardJetP4s_.size();i++) hardJetP4(i);
+  for (unsigned j=0;j<subJetP4s_.size();j++)  subJetP4(j);
+  areaSeqOwner_ = cs;
+  areaSeq_      = dynamic_cast<const fastjet::ClusterSequenceAreaBase*>(cs.get());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::resizeOwnerIndex(unsigned n)
+{
+  if (ownerIndex_&&n>owners_.size()) owners_.resize(n,unowned());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::reserve(unsigned nJets,
+					  unsigned nSubJets,
+					  unsigned nConstituents)
+{
+  if (storage_==PseudoJets) hardJets_.reserve(nJets);
+  hardJetP4s_.reserve(nJets);
+  hardJetAreaHist_.reserve(nJets);
+  subJetBegins_.reserve(nJets);
+  if (storage_==PseudoJets) subJets_.reserve(nSubJets);
+  subJetP4s_.reserve(nSubJets);
+  subJetAreaHist_.reserve(nSubJets);
+  constituentBegins_.reserve(nSubJets);
+  constituents_.reserve(nConstituents);
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::addJet(const fastjet::PseudoJet& hardJet,
+					 double hardJetArea)
+{
+  if (storage_==PseudoJets) hardJets_.push_back(hardJet);
+  hardJetP4s_.push_back(fourVector(hardJet,hardJetArea));
+  hardJetAreaHist_.push_back(-1);
+  subJetBegins_.push_back(subJetP4s_.size());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::addJetLazyArea(const fastjet::PseudoJet& hardJet)
+{
+  addJet(hardJet);
+  if (0!=areaSeq_) hardJetAreaHist_.back() = hardJet.cluster_hist_index();
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::addSubJet(const fastjet::PseudoJet& subJet,
+					    double subJetArea)
+{
+  if (storage_==PseudoJets) subJets_.push_back(subJet);
+  subJetP4s_.push_back(fourVector(subJet,subJetArea));
+  subJetAreaHist_.push_back(-1);
+  constituentBegins_.push_back(constituents_.size());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::addSubJetLazyArea(const fastjet::PseudoJet& subJet)
+{
+  addSubJet(subJet);
+  if (0!=areaSeq_) subJetAreaHist_.back() = subJet.cluster_hist_index();
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::addConstituents(const vector<int>& indices)
+{
+  if (ownerIndex_) {
+    for (unsigned k=0;k<indices.size();k++) addConstituent(indices[k]);
+    return;
+  }
+  constituents_.insert(constituents_.end(),indices.begin(),indices.end());
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::popSubJet()
+{
+  if (subJetP4s_.empty()) return;
+  // constituents first added by this subjet become unowned again
+  if (ownerIndex_) {
+    int iSubJet = subJetP4s_.size()-1;
+    for (unsigned k=constituentBegins_.back();k<constituents_.size();k++) {
+      int index = constituents_[k];
+      if (index>=0&&owners_[index].subJet==iSubJet) owners_[index] = unowned();
+    }
+  }
+  constituents_.resize(constituentBegins_.back());
+  constituentBegins_.pop_back();
+  subJetP4s_.pop_back();
+  subJetAreaHist_.pop_back();
+  if (storage_==PseudoJets) subJets_.pop_back();
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::toCompoundPseudoJets(vector<CompoundPseudoJet>& jets) const
+{
+  jets.reserve(jets.size()+size());
+  for (unsigned i=0;i<size();i++) jets.push_back(compoundPseudoJet(i));
+}
+
+
+//______________________________________________________________________________
+CompoundPseudoJet CompoundPseudoJetCollection::compoundPseudoJet(unsigned i) const
+{
+  vector<CompoundPseudoSubJet> subJets;
+  subJets.reserve(nSubJets(i));
+  for (unsigned j=subJetBegin(i);j<subJetEnd(i);j++) {
+    vector<int> indices(constituents_.begin()+constituentBegin(j),
+			constituents_.begin()+constituentEnd(j));
+    if (storage_==PseudoJets)
+      subJets.push_back(CompoundPseudoSubJet(subJets_[j],subJetArea(j),indices));
+    else
+      subJets.push_back(CompoundPseudoSubJet(pseudoJet(subJetP4(j)),subJetArea(j),indices));
+  }
+  if (storage_==PseudoJets)
+    return CompoundPseudoJet(hardJets_[i],hardJetArea(i),subJets);
+  return CompoundPseudoJet(pseudoJet(hardJetP4(i)),hardJetArea(i),subJets);
+}
+
+
+//______________________________________________________________________________
+CompoundPseudoJetCollection::FourVector
+CompoundPseudoJetCollection::fourVector(const fastjet::PseudoJet& jet,double area)
+{
+  FourVector p4;
+  p4.px   = jet.px();
+  p4.py   = jet.py();
+  p4.pz   = jet.pz();
+  p4.e    = jet.e();
+  p4.area = area;
+  return p4;
+}
+
+
+//______________________________________________________________________________
+double CompoundPseudoJetCollection::area(int histIndex) const
+{
+  const fastjet::ClusterSequence::history_element& elem = areaSeq_->history()[histIndex];
+  return areaSeq_->area(areaSeq_->jets()[elem.jetp_index]);
+}
+
+
+//______________________________________________________________________________
+const CompoundPseudoJetCollection::Owner& CompoundPseudoJetCollection::unowned()
+{
+  static const Owner none = { -1, -1 };
+  return none;
+}
+
+
+//______________________________________________________________________________
+void CompoundPseudoJetCollection::throwNoPseudoJets()
+{
+  throw cms::Exception("LogicError")
+    <<"CompoundPseudoJetCollection: no PseudoJets with FourVectors storage, "
+    <<"use hardJetP4()/subJetP4()\n";
+}
+
+
+//______________________________________________________________________________
+fastjet::PseudoJet CompoundPseudoJetCollection::pseudoJet(const FourVector& p4)
+{
+  return fastjet::PseudoJet(p4.px,p4.py,p4.pz,p4.e);
+}
@@ -8,10 +8,17 @@
 
 #include "RecoJets/JetAlgorithms/interface/FastPrunePlugin.hh"
 
+#include "fastjet/Error.hh"
+
 #include <sstream>
 #include <cmath>
 #include <vector>
 #include <algorithm>
+#include <memory>
+
+#include "tbb/mutex.h"
+#include "tbb/parallel_for.h"
+#include "tbb/blocked_range.h"
 using namespace std;
 
 using namespace fastjet;
@@ -23,7 +30,8 @@ FastPrunePlugin::FastPrunePlugin (const JetDefinition & find_definition,
 		_find_definition(find_definition),
 		_prune_definition(prune_definition),
 		_minpT(20.),
-		_unpruned_seq(NULL),
+		_parallel_pruning(false),
+		_history_pruning(false),
 		_pruned_recombiner(0),
 		_cut_setter(new DefaultCutSetter(zcut, Rcut_factor))
 {
@@ -50,7 +58,8 @@ FastPrunePlugin::FastPrunePlugin (const JetDefinition & find_definition,
 		_find_definition(find_definition),
 		_prune_definition(prune_definition),
 		_minpT(20.),
-		_unpruned_seq(NULL),
+		_parallel_pruning(false),
+		_history_pruning(false),
 		_pruned_recombiner(new PrunedRecombiner(recomb, zcut, 0.0)),
 		_cut_setter(new DefaultCutSetter(zcut, Rcut_factor))
 {}
@@ -61,7 +70,8 @@ FastPrunePlugin::FastPrunePlugin (const JetDefinition & find_definition,
 		_find_definition(find_definition),
 		_prune_definition(prune_definition),
 		_minpT(20.),
-		_unpruned_seq(NULL),
+		_parallel_pruning(false),
+		_history_pruning(false),
 		_pruned_recombiner(0),
 		_cut_setter(cut_setter)
 {
@@ -80,11 +90,83 @@ FastPrunePlugin::FastPrunePlugin (const JetDefinition & find_definition,
 		_find_definition(find_definition),
 		_prune_definition(prune_definition),
 		_minpT(20.),
-		_unpruned_seq(NULL),
+		_parallel_pruning(false),
+		_history_pruning(false),
 		_pruned_recombiner(new PrunedRecombiner(recomb)),
 		_cut_setter(cut_setter)
 {}
 
+namespace {
+
+	// Prunes the unpruned jets of a range, each with its own
+	//   PrunedRecombiner, and keeps the pruned sequences for the replay
+	//   into the input sequence.  The prune definition and the cut setter
+	//   are only read.
+	class PruneJets {
+	public:
+		PruneJets(const FastPrunePlugin::CutSetter & cut_setter,
+		          const PrunedRecombiner & prototype,
+		          const JetDefinition & prune_definition,
+		          const ClusterSequence & unpruned_seq,
+		          const vector<PseudoJet> & unpruned_jets,
+		          const vector<vector<PseudoJet> > & constituents,
+		          vector<SharedPtr<ClusterSequence> > & pruned_seqs,
+		          vector<vector<int> > & pruned_pseudojets)
+			: _cut_setter(cut_setter), _prototype(prototype),
+			  _prune_definition(prune_definition), _unpruned_seq(unpruned_seq),
+			  _unpruned_jets(unpruned_jets), _constituents(constituents),
+			  _pruned_seqs(pruned_seqs), _pruned_pseudojets(pruned_pseudojets) {}
+
+		void operator()(const tbb::blocked_range<size_t> & range) const {
+			for (size_t i = range.begin(); i != range.end(); ++i) {
+				double zcut, Rcut;
+				_cut_setter.get_cuts(_unpruned_jets[i], _unpruned_seq, zcut, Rcut);
+				PrunedRecombiner recombiner(_prototype);
+				recombiner.reset(zcut, Rcut);
+				JetDefinition prune_definition(_prune_definition);
+				prune_definition.set_recombiner(&recombiner);
+				// the pruned sequence keeps its history after the recombiner
+				//   is gone, which is all _output_mergings() reads
+				_pruned_seqs[i].reset(new ClusterSequence(_constituents[i],
+				                                          prune_definition));
+				_pruned_pseudojets[i] = recombiner.pruned_pseudojets();
+			}
+		}
+
+	private:
+		const FastPrunePlugin::CutSetter & _cut_setter;
+		const PrunedRecombiner & _prototype;
+		const JetDefinition & _prune_definition;
+		const ClusterSequence & _unpruned_seq;
+		const vector<PseudoJet> & _unpruned_jets;
+		const vector<vector<PseudoJet> > & _constituents;
+		vector<SharedPtr<ClusterSequence> > & _pruned_seqs;
+		vector<vector<int> > & _pruned_pseudojets;
+	};
+
+}
+
+// serializes the SetCuts() calls of CutSetters without their own get_cuts()
+static tbb::mutex cut_setter_mutex;
+
+void FastPrunePlugin::CutSetter::get_cuts(const PseudoJet &jet,
+                                          const ClusterSequence &clust_seq,
+                                          double &z, double &R) const {
+	tbb::mutex::scoped_lock lock(cut_setter_mutex);
+	CutSetter *self = const_cast<CutSetter*>(this);
+	self->SetCuts(jet, clust_seq);
+	z = zcut;
+	R = Rcut;
+}
+
+void FastPrunePlugin::set_history_pruning(bool history) {
+	if (history && (_find_definition.jet_algorithm() != cambridge_algorithm ||
+	                _prune_definition.jet_algorithm() != cambridge_algorithm))
+		throw Error("FastPrunePlugin: history pruning needs Cambridge/Aachen "
+		            "find and prune definitions");
+	_history_pruning = history;
+}
+
 string FastPrunePlugin::description () const {
 	ostringstream desc;
 
@@ -101,6 +183,10 @@ string FastPrunePlugin::description () const {
 		desc << cs->Rcut_factor;
 	else
 		desc << "[dynamic]";
+	// both change the output, so sequences clustered with different values
+	// must not be shared (e.g. by a ClusterSequenceCache)
+	desc << ", unpruned minpT = " << _minpT;
+	if (_history_pruning) desc << ", history pruning";
 	desc << "\n"
 	     << "----------------------- \n" ;
 
@@ -119,112 +205,339 @@ string FastPrunePlugin::description () const {
 //   children.  For this reason, only inclusive_jets() is sensible to use with
 //   the final ClusterSequence.  The substructure, e.g., constituents() of a
 //   pruned jet will not include the pruned away branchings.
+// The plugin itself is not changed, so several threads can run it at once.
 void FastPrunePlugin::run_clustering(ClusterSequence & input_seq) const {
+	_Unpruned unpruned;
+	_find_unpruned(input_seq.jets(), unpruned);
+	input_seq.plugin_associate_extras(std::auto_ptr<ClusterSequence::Extras>(
+		_prune(unpruned, *_cut_setter, input_seq)));
+}
+
+
+// Plugin of the ClusterSequences made by run_scan(): prunes the unpruned
+//   jets found by run_scan() with one of its CutSetters.  The unpruned jets
+//   and the CutSetter are only used while the sequence runs; the plugin
+//   itself is kept alive by the Extras of its sequence.
+class FastPrunePlugin::_ScanPlugin : public JetDefinition::Plugin {
+public:
+	_ScanPlugin(const FastPrunePlugin & parent, const _Unpruned & unpruned,
+	            const CutSetter & cut_setter) :
+		_parent(parent), _unpruned(&unpruned), _cut_setter(&cut_setter),
+		_self(0), _R(parent.R()) {
+		ostringstream desc;
+		desc << parent.description() << "(pruning scan, "
+		     << "zcut = " << cut_setter.zcut << ")\n";
+		_description = desc.str();
+	}
+
+	void set_self(const SharedPtr<JetDefinition::Plugin> & self) {_self = &self;}
+
+	virtual std::string description () const {return _description;}
+	virtual double R() const {return _R;}
+
+	virtual void run_clustering(ClusterSequence & input_seq) const {
+		std::auto_ptr<Extras> extras(_parent._prune(*_unpruned, *_cut_setter,
+		                                            input_seq));
+		extras->_scan_plugin = *_self;
+		input_seq.plugin_associate_extras(
+			std::auto_ptr<ClusterSequence::Extras>(extras));
+	}
+
+private:
+	const FastPrunePlugin & _parent;
+	const _Unpruned * _unpruned;
+	const CutSetter * _cut_setter;
+	const SharedPtr<JetDefinition::Plugin> * _self;
+	double _R;
+	std::string _description;
+};
+
+
+void FastPrunePlugin::run_scan(const vector<PseudoJet> & particles,
+                               const vector<const CutSetter*> & cut_setters,
+                               vector<vector<PseudoJet> > & pruned_jets,
+                               double ptmin) const {
+	_Unpruned unpruned;
+	_find_unpruned(particles, unpruned);
+
+	pruned_jets.resize(cut_setters.size());
+	for (unsigned int k = 0; k < cut_setters.size(); k++) {
+		_ScanPlugin *plugin = new _ScanPlugin(*this, unpruned, *cut_setters[k]);
+		SharedPtr<JetDefinition::Plugin> plugin_ptr(plugin);
+		plugin->set_self(plugin_ptr);
+		JetDefinition scan_definition(plugin);
+
+		ClusterSequence *pruned_seq = new ClusterSequence(particles, scan_definition);
+		pruned_jets[k] = sorted_by_pt(pruned_seq->inclusive_jets(ptmin));
+		if (pruned_jets[k].empty())
+			delete pruned_seq;
+		else
+			pruned_seq->delete_self_when_unused();
+	}
+}
+
+
+// Finds the unpruned jets of particles and their constituents.
+void FastPrunePlugin::_find_unpruned(const vector<PseudoJet> & particles,
+                                     _Unpruned & unpruned) const {
+	// ClusterSequence for initial (unpruned) jet finding; the particles
+	//   keep their user_index's, so that the sequence can be used by others
+	unpruned.seq.reset(new ClusterSequence(particles, _find_definition));
+
+	// the jets to prune, in pT order
+	unpruned.jets = sorted_by_pt(unpruned.seq->inclusive_jets(_minpT));
+
+	// unpruned jet of each input, for the Extras, labelled in one pass over
+	//   the unpruned history: every element belongs to the jet of its child,
+	//   and children come after their parents, so walk it backwards
+	const vector<ClusterSequence::history_element> & unpruned_hist =
+		unpruned.seq->history();
+	vector<int> unpruned_jet_of_hist(unpruned_hist.size(), -1);
+	for (unsigned int i = 0; i < unpruned.jets.size(); i++)
+		unpruned_jet_of_hist[unpruned.jets[i].cluster_hist_index()] = i;
+	for (int h = int(unpruned_hist.size()) - 1; h >= 0; h--) {
+		int child = unpruned_hist[h].child;
+		if (unpruned_jet_of_hist[h] < 0 && child >= 0)
+			unpruned_jet_of_hist[h] = unpruned_jet_of_hist[child];
+	}
 
-	// this will be filled in the output_mergings() step
-	_pruned_subjets.clear();
-
-	vector<PseudoJet> inputs = input_seq.jets();
-	// Record user_index's so we can match PJ's in pruned jets to PJ's in
-	//   input_seq.
-	// Use i+1 to distinguish from the default, which in some places appears to
-	//   be 0.
-	// Note that we're working with a local copy of the input jets, so we don't
-	//   change the indices in input_seq.
-	for (unsigned int i = 0; i < inputs.size(); i++)
-		inputs[i].set_user_index(i+1);
-
-	// ClusterSequence for initial (unpruned) jet finding
-	if(_unpruned_seq) delete _unpruned_seq;
-	_unpruned_seq = new ClusterSequence(inputs, _find_definition);
-
-	// now, for each jet, construct a pruned version:
-	vector<PseudoJet> unpruned_jets = 
-	                  sorted_by_pt(_unpruned_seq->inclusive_jets(_minpT));
-
-	for (unsigned int i = 0; i < unpruned_jets.size(); i++) {
-		_cut_setter->SetCuts(unpruned_jets[i], *_unpruned_seq);
-		_pruned_recombiner->reset(_cut_setter->zcut, _cut_setter->Rcut);
-		_prune_definition.set_recombiner(_pruned_recombiner);
-
-		// temp way to get constituents, to compare to new version
-		vector<PseudoJet> constituents;
-		for (size_t j = 0; j < inputs.size(); ++j)
-			if (_unpruned_seq->object_in_jet(inputs[j], unpruned_jets[i])) {
-				constituents.push_back(inputs[j]);
+	// constituents of each unpruned jet and their index in input_seq, in
+	//   input order; the history index of input j is j
+	unpruned.jet_of_input.assign(unpruned_jet_of_hist.begin(),
+	                             unpruned_jet_of_hist.begin() + particles.size());
+	unpruned.jet_of_hist.swap(unpruned_jet_of_hist);
+	if (_history_pruning) return; // no reclustering
+
+	unpruned.constituents.assign(unpruned.jets.size(), vector<PseudoJet>());
+	unpruned.constituent_indices.assign(unpruned.jets.size(), vector<int>());
+	for (size_t j = 0; j < particles.size(); ++j) {
+		int i = unpruned.jet_of_input[j];
+		if (i >= 0) {
+			unpruned.constituents[i].push_back(particles[j]);
+			unpruned.constituent_indices[i].push_back(j);
+		}
+	}
+}
+
+
+// Prunes the unpruned jets with cut_setter and records the pruned jets in
+//   input_seq, which must have been made from the same particles.  Returns
+//   the Extras for input_seq.
+std::auto_ptr<FastPrunePlugin::Extras>
+FastPrunePlugin::_prune(const _Unpruned & unpruned, const CutSetter & cut_setter,
+                        ClusterSequence & input_seq) const {
+
+	const vector<PseudoJet> & unpruned_jets = unpruned.jets;
+	const vector<vector<PseudoJet> > & constituents = unpruned.constituents;
+
+	// pruned branches of all jets, and the offset of each jet's branches;
+	//   filled in the output_mergings() step
+	vector<int> pruned_branches;
+	vector<unsigned> pruned_branch_begins;
+
+	// buffers for _output_mergings(), shared by all jets
+	vector<char> is_pruned;
+	vector<int> out_index;
+	pruned_branch_begins.reserve(unpruned_jets.size() + 1);
+
+	if (_history_pruning) {
+		_prune_history(unpruned, cut_setter, input_seq,
+		               pruned_branches, pruned_branch_begins);
+	} else if (_parallel_pruning && unpruned_jets.size() > 1) {
+		// prune all jets concurrently, then replay the mergings serially in
+		//   pT order, so that the output does not depend on the scheduling
+		vector<SharedPtr<ClusterSequence> > pruned_seqs(unpruned_jets.size());
+		vector<vector<int> > pruned_pseudojets(unpruned_jets.size());
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, unpruned_jets.size(), 1),
+		                  PruneJets(cut_setter, *_pruned_recombiner,
+		                            _prune_definition, *unpruned.seq,
+		                            unpruned_jets, constituents,
+		                            pruned_seqs, pruned_pseudojets));
+		for (unsigned int i = 0; i < unpruned_jets.size(); i++) {
+			pruned_branch_begins.push_back(pruned_branches.size());
+			_output_mergings(*pruned_seqs[i], pruned_pseudojets[i],
+			                 unpruned.constituent_indices[i],
+			                 is_pruned, out_index, input_seq, pruned_branches);
+		}
+	} else {
+		// this clustering's own PrunedRecombiner and prune definition
+		PrunedRecombiner pruned_recombiner(*_pruned_recombiner);
+		JetDefinition prune_definition(_prune_definition);
+		prune_definition.set_recombiner(&pruned_recombiner);
+
+		for (unsigned int i = 0; i < unpruned_jets.size(); i++) {
+			double zcut, Rcut;
+			cut_setter.get_cuts(unpruned_jets[i], *unpruned.seq, zcut, Rcut);
+			pruned_recombiner.reset(zcut, Rcut);
+
+			ClusterSequence pruned_seq(constituents[i], prune_definition);
+			
+			pruned_branch_begins.push_back(pruned_branches.size());
+			_output_mergings(pruned_seq, pruned_recombiner.pruned_pseudojets(),
+			                 unpruned.constituent_indices[i],
+			                 is_pruned, out_index, input_seq, pruned_branches);
+		}
+	}
+	pruned_branch_begins.push_back(pruned_branches.size());
+
+	return std::auto_ptr<Extras>(
+		new Extras(unpruned.seq, unpruned_jets, unpruned.jet_of_input,
+		           pruned_branches, pruned_branch_begins));
+}
+
+
+// History pruning (C/A only): instead of reclustering the constituents of
+//   each jet, walk the jet's unpruned history bottom-up, keeping the pruned
+//   momentum of every element, and apply the pruning test of the
+//   PrunedRecombiner to the pruned momenta of the parents of each merging.
+//   The mergings that survive are recorded in out_seq as they are found,
+//   with the dij = DeltaR^2/R^2 of the prune definition (and 1 for the
+//   final merging with the beam), as the reclustering would record them.
+//   See the header for where the two modes can differ.
+void FastPrunePlugin::_prune_history(const _Unpruned & unpruned,
+                                     const CutSetter & cut_setter,
+                                     ClusterSequence & out_seq,
+                                     vector<int> & pruned_branches,
+                                     vector<unsigned> & pruned_branch_begins) const {
+	const ClusterSequence & seq = *unpruned.seq;
+	const vector<ClusterSequence::history_element> & hist = seq.history();
+	const vector<int> & jet_of_hist = unpruned.jet_of_hist;
+	unsigned int n_jets = unpruned.jets.size();
+
+	// history elements of each jet, in history order (parents first)
+	vector<unsigned> begins(n_jets + 1, 0);
+	for (size_t h = 0; h < hist.size(); h++)
+		if (jet_of_hist[h] >= 0) begins[jet_of_hist[h] + 1]++;
+	for (unsigned int i = 0; i < n_jets; i++)
+		begins[i+1] += begins[i];
+	vector<int> elements(begins[n_jets]);
+	vector<unsigned> next(begins.begin(), begins.end() - 1);
+	for (size_t h = 0; h < hist.size(); h++)
+		if (jet_of_hist[h] >= 0) elements[next[jet_of_hist[h]]++] = h;
+
+	PrunedRecombiner pruned_recombiner(*_pruned_recombiner);
+	double inv_R2 = 1.0 / (_prune_definition.R() * _prune_definition.R());
+
+	// pruned momentum of each element (with its history index) and index in
+	//   out_seq of the corresponding PseudoJet; input j is PseudoJet j of
+	//   both sequences
+	vector<PseudoJet> pruned_p(hist.size());
+	vector<int> out_index(hist.size(), -1);
+
+	for (unsigned int i = 0; i < n_jets; i++) {
+		double zcut, Rcut;
+		cut_setter.get_cuts(unpruned.jets[i], seq, zcut, Rcut);
+		pruned_recombiner.reset(zcut, Rcut);
+		pruned_branch_begins.push_back(pruned_branches.size());
+
+		for (unsigned k = begins[i]; k < begins[i+1]; k++) {
+			int h = elements[k];
+			const ClusterSequence::history_element & elem = hist[h];
+			if (elem.parent1 == ClusterSequence::InexistentParent) {
+				pruned_p[h] = seq.jets()[elem.jetp_index];
+				out_index[h] = elem.jetp_index;
+				continue;
 			}
-		ClusterSequence pruned_seq(constituents, _prune_definition);
-		
-		vector<int> pruned_PJs = _pruned_recombiner->pruned_pseudojets();
-		_output_mergings(pruned_seq, pruned_PJs, input_seq);
+
+			int parent1 = elem.parent1;
+			int parent2 = elem.parent2;
+			size_t n_pruned = pruned_recombiner.pruned_pseudojets().size();
+			pruned_recombiner.recombine(pruned_p[parent1], pruned_p[parent2],
+			                            pruned_p[h]);
+			if (pruned_recombiner.pruned_pseudojets().size() > n_pruned) {
+				// pruned away one parent -- the child is the other one
+				int pruned = pruned_recombiner.pruned_pseudojets().back();
+				int kept = (pruned == parent1) ? parent2 : parent1;
+				out_index[h] = out_index[kept];
+				pruned_branches.push_back(
+					out_seq.jets()[out_index[pruned]].cluster_hist_index());
+			} else {
+				int new_jet_index = -1;
+				double dij = pruned_p[parent1].squared_distance(pruned_p[parent2])
+				             * inv_R2;
+				out_seq.plugin_record_ij_recombination(out_index[parent1],
+				                                       out_index[parent2],
+				                                       dij, new_jet_index);
+				out_index[h] = new_jet_index;
+			}
+			pruned_p[h].set_cluster_hist_index(h);
+		}
+
+		out_seq.plugin_record_iB_recombination(
+			out_index[unpruned.jets[i].cluster_hist_index()], 1.0);
 	}
 }
 
 
 // Takes the merging structure of "in_seq" and feeds this into "out_seq" using 
 //   _plugin_record_{ij,iB}_recombination().
-// PJ's in the input CS should have user_index's that are their (index+1) in 
-//	  _jets() in the output CS (the output CS should be the input CS to
-//	  run_clustering()).
+// Particle k of in_seq is particle input_indices[k] of out_seq (the output
+//	  CS should be the input CS to run_clustering()).
 // This allows us to build up the same jet in out_seq as already exists in
-//   in_seq.								 														 
-void FastPrunePlugin::_output_mergings(ClusterSequence & in_seq,
-                                       vector<int> & pruned_pseudojets,
-                                       ClusterSequence & out_seq) const {
-	// vector to store the pruned subjets for this jet
-	vector<PseudoJet> temp_pruned_subjets;
+//   in_seq.
+// is_pruned and out_index are work buffers, so that they can be reused for
+//   all the jets of an event; in_seq is only read.								 														 
+void FastPrunePlugin::_output_mergings(const ClusterSequence & in_seq,
+                                       const vector<int> & pruned_pseudojets,
+                                       const vector<int> & input_indices,
+                                       vector<char> & is_pruned,
+                                       vector<int> & out_index,
+                                       ClusterSequence & out_seq,
+                                       vector<int> & pruned_branches) const {
 
-	vector<PseudoJet> p = in_seq.jets();
-
-	// sort this vector so we can binary search it
-	sort(pruned_pseudojets.begin(), pruned_pseudojets.end());
+	const vector<PseudoJet> & p = in_seq.jets();
 
 	// get the history from in_seq
 	const vector<ClusterSequence::history_element> & hist = in_seq.history();
+
+	// flag the pruned history elements
+	is_pruned.assign(hist.size(), 0);
+	for (size_t i = 0; i < pruned_pseudojets.size(); i++)
+		is_pruned[pruned_pseudojets[i]] = 1;
+
+	// index in out_seq of each PseudoJet of in_seq, from input_indices for
+	//   the particles; recombined PseudoJets are filled in below
+	out_index.assign(p.size(), -1);
 	vector<ClusterSequence::history_element>::const_iterator
 		iter = hist.begin();
 	
 	// skip particle input elements
-	while (iter->parent1 == ClusterSequence::InexistentParent)
-		iter++;
+	for (; iter->parent1 == ClusterSequence::InexistentParent; iter++)
+		out_index[iter->jetp_index] = input_indices[iter->jetp_index];
 	
-	// Walk through history.  PseudoJets in in_seq should have a user_index
+	// Walk through history.  PseudoJets in in_seq have an out_index
 	//   corresponding to their index in out_seq.  Note that when we create a
-	//   new PJ via record_ij we need to set the user_index of our local copy.
+	//   new PJ via record_ij we need to set the out_index of the child.
 	for (; iter != hist.end(); iter++) {
 		int new_jet_index = -1;
 		int jet_index = iter->jetp_index;
 		int parent1 = iter->parent1;
 		int parent2 = iter->parent2;
-		int parent1_index = p[hist[iter->parent1].jetp_index].user_index() - 1;
+		int parent1_index = out_index[hist[parent1].jetp_index];
 
 		if (parent2 == ClusterSequence::BeamJet) {
 			out_seq.plugin_record_iB_recombination(parent1_index, iter->dij);
 		} else {
-			int parent2_index = p[hist[parent2].jetp_index].user_index() - 1;
+			int parent2_index = out_index[hist[parent2].jetp_index];
 			
-			// Check if either parent is stored in pruned_pseudojets
+			// Check if either parent is flagged as pruned
 			//   Note that it is the history index that is stored
-			if (binary_search(pruned_pseudojets.begin(), pruned_pseudojets.end(),
-                        parent2)) {
+			if (is_pruned[parent2]) {
 				// pruned away parent2 -- just give child parent1's index
-				p[jet_index].set_user_index(p[hist[parent1].jetp_index].user_index());
-				temp_pruned_subjets.push_back(out_seq.jets()[parent2_index]);
-			} else if (binary_search(pruned_pseudojets.begin(), pruned_pseudojets.end(),
-                             parent1)) {
+				out_index[jet_index] = parent1_index;
+				pruned_branches.push_back(out_seq.jets()[parent2_index].cluster_hist_index());
+			} else if (is_pruned[parent1]) {
 				// pruned away parent1 -- just give child parent2's index
-				p[jet_index].set_user_index(p[hist[parent2].jetp_index].user_index());
-				temp_pruned_subjets.push_back(out_seq.jets()[parent1_index]);
+				out_index[jet_index] = parent2_index;
+				pruned_branches.push_back(out_seq.jets()[parent1_index].cluster_hist_index());
 			} else {
 				// no pruning -- record combination and index for child
 				out_seq.plugin_record_ij_recombination(parent1_index, parent2_index,
                                                iter->dij, new_jet_index);
-				p[jet_index].set_user_index(new_jet_index + 1);
+				out_index[jet_index] = new_jet_index;
 			}
 		}
 	}
-	
-	_pruned_subjets.push_back(temp_pruned_subjets);
 }
 
 
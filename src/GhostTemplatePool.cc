@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GhostTemplatePool
+// -----------------
+//
+// see RecoJets/JetAlgorithms/interface/GhostTemplatePool.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/GhostTemplatePool.h"
+#include "RecoJets/JetAlgorithms/interface/ClusterSequenceCache.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh>
+
+#include <boost/functional/hash.hpp>
+
+#include <sstream>
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+GhostTemplatePool::GhostTemplatePool(const fastjet::GhostedAreaSpec& ghostSpec,
+				     unsigned nTemplates,int seed)
+  : ghostSpec_(ghostSpec)
+  , seed_(seed)
+  , ghostArea_(ghostSpec.actual_ghost_area())
+  , templates_(nTemplates)
+{
+  if (nTemplates==0)
+    throw cms::Exception("InvalidParameter")
+      <<"GhostTemplatePool: at least one ghost template is required\n";
+
+  // the ghost random generator is shared by all GhostedAreaSpecs: seed it
+  // for each template and leave it as it was found, without letting ghosted
+  // clusterings draw from it meanwhile
+  tbb::mutex::scoped_lock lock(ClusterSequenceCache::ghostRandomMutex());
+  vector<int> status;
+  ghostSpec_.get_random_status(status);
+
+  vector<int> seeds(2);
+  seeds[0] = seed_;
+  for (unsigned i=0;i<nTemplates;i++) {
+    seeds[1] = i+1;
+    ghostSpec_.set_random_status(seeds);
+    ghostSpec_.add_ghosts(templates_[i]);
+  }
+
+  ghostSpec_.set_random_status(status);
+}
+
+
+//______________________________________________________________________________
+GhostTemplatePool::~GhostTemplatePool()
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+unsigned GhostTemplatePool::select(const vector<fastjet::PseudoJet>& inputs) const
+{
+  size_t seed(0);
+  for (size_t i=0;i<inputs.size();i++) {
+    const fastjet::PseudoJet& pj = inputs[i];
+    boost::hash_combine(seed,pj.px());
+    boost::hash_combine(seed,pj.py());
+    boost::hash_combine(seed,pj.pz());
+    boost::hash_combine(seed,pj.E());
+  }
+  return seed%templates_.size();
+}
+
+
+//______________________________________________________________________________
+string GhostTemplatePool::description(unsigned i) const
+{
+  std::stringstream ss;
+  ss<<"explicit ghost template "<<i<<"/"<<templates_.size()
+    <<" with seed "<<seed_<<", "<<ghostSpec_.description();
+  return ss.str();
+}
+
+
+//______________________________________________________________________________
+boost::shared_ptr<fastjet::ClusterSequence>
+GhostTemplatePool::cluster(const vector<fastjet::PseudoJet>& inputs,
+			   const fastjet::JetDefinition&     jetDef,
+			   unsigned                          i) const
+{
+  return boost::shared_ptr<fastjet::ClusterSequence>
+    (new fastjet::ClusterSequenceActiveAreaExplicitGhosts(inputs,jetDef,
+							  templates_[i],ghostArea_));
+}
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// GroomingEngine
+// --------------
+//
+// see RecoJets/JetAlgorithms/interface/GroomingEngine.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/GroomingEngine.h"
+#include "RecoJets/JetAlgorithms/interface/JetSplittingRecord.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <fastjet/CompositeJetStructure.hh>
+
+#include <cmath>
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of GroomedJets member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+void GroomedJets::clear()
+{
+  prunedSequence.reset();
+  fatJets.clear();
+  prunedJets.clear();
+  trimmedJets.clear();
+  filteredJets.clear();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+GroomingEngine::GroomingEngine(double rParam,
+			       double jetPtMin,
+			       double zcut,
+			       double rcutFactor,
+			       double rTrim,
+			       double ptFracTrim,
+			       double massDropCut,
+			       double asymmCut,
+			       bool   asymmCutLater,
+			       double rFilt)
+  : rParam_(rParam)
+  , rTrim_(rTrim)
+  , ptFracTrim_(ptFracTrim)
+  , filter_("GroomingEngine","ca",0,rParam,rFilt,jetPtMin,
+	    massDropCut,asymmCut,asymmCutLater,false,5.0,1,0.01,false)
+{
+  // the filter's fat jets, sorted_by_pt(inclusive_jets(jetPtMin)) of the
+  // unpruned sequence, are the plugin's unpruned jets
+  fastjet::JetDefinition findDef(fastjet::cambridge_algorithm,rParam);
+  fastjet::JetDefinition pruneDef(fastjet::cambridge_algorithm,0.5*M_PI);
+  prunePlugin_.reset(new fastjet::FastPrunePlugin(findDef,pruneDef,zcut,rcutFactor));
+  prunePlugin_->set_unpruned_minpT(jetPtMin);
+  pruneJetDef_.reset(new fastjet::JetDefinition(prunePlugin_.get()));
+}
+
+
+//______________________________________________________________________________
+GroomingEngine::~GroomingEngine()
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+void GroomingEngine::run(const vector<fastjet::PseudoJet>& inputs,
+			 GroomedJets& jets,
+			 ClusterSequenceCache* cache) const
+{
+  jets.clear();
+  jets.prunedSequence = (0!=cache) ?
+    cache->get(inputs,*pruneJetDef_) :
+    ClusterSequenceCache::cluster(inputs,*pruneJetDef_);
+
+  const fastjet::ClusterSequence& prunedSeq = *jets.prunedSequence;
+  const fastjet::FastPrunePlugin::Extras* extras =
+    dynamic_cast<const fastjet::FastPrunePlugin::Extras*>(prunedSeq.extras());
+  if (0==extras)
+    throw cms::Exception("LogicError")
+      <<"GroomingEngine: the pruned sequence has no FastPrunePlugin extras\n";
+
+  const fastjet::ClusterSequence& unprunedSeq = extras->unpruned_sequence();
+  jets.fatJets = extras->unpruned_jets();
+  unsigned nFat = jets.fatJets.size();
+
+  // PRUNING: the reclustered constituents of a fat jet may end up in several
+  // pruned jets (pruned merges leave pieces apart); keep the hardest one
+  jets.prunedJets.assign(nFat,fastjet::PseudoJet(0.0,0.0,0.0,0.0));
+  vector<fastjet::PseudoJet> prunedJets = prunedSeq.inclusive_jets();
+  for (unsigned i=0;i<prunedJets.size();i++) {
+    int iFat = extras->unpruned_jet_index(prunedSeq,prunedJets[i]);
+    if (iFat>=0&&prunedJets[i].perp2()>jets.prunedJets[iFat].perp2())
+      jets.prunedJets[iFat] = prunedJets[i];
+  }
+
+  // TRIMMING: exclusive C/A subjets at rTrim above the pt fraction
+  JetSplittingRecord         record;
+  vector<int>                subJetNodes;
+  vector<fastjet::PseudoJet> subJets;
+  double dcut = rTrim_*rTrim_/rParam_/rParam_;
+  jets.trimmedJets.reserve(nFat);
+  for (unsigned iFat=0;iFat<nFat;iFat++) {
+    record.reset(unprunedSeq,jets.fatJets[iFat]);
+    record.exclusiveSubjets(record.root(),dcut,subJetNodes);
+    double ptMin = ptFracTrim_*record[record.root()].pt;
+    subJets.clear();
+    for (unsigned i=0;i<subJetNodes.size();i++)
+      if (record[subJetNodes[i]].pt>ptMin) subJets.push_back(record.pseudoJet(subJetNodes[i]));
+    jets.trimmedJets.push_back(fastjet::join(fastjet::sorted_by_pt(subJets)));
+  }
+
+  // MASS DROP AND FILTERING
+  filter_.run(unprunedSeq,jets.filteredJets);
+}
@@ -18,6 +18,7 @@
 //----------------------------------------------------------------------
 
 #include "RecoJets/JetAlgorithms/interface/HEPTopTaggerWrapper.h"
+#include "RecoJets/JetAlgorithms/interface/SmallNClusterSequence.h"
 
 #include <fastjet/Error.hh>
 #include <fastjet/JetDefinition.hh>
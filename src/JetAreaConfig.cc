@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// JetAreaConfig
+// -------------
+//
+// see RecoJets/JetAlgorithms/interface/JetAreaConfig.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/JetAreaConfig.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+fastjet::GhostedAreaSpec JetAreaConfig::ghostSpec() const
+{
+  return fastjet::GhostedAreaSpec(ghostEtaMax,activeAreaRepeats,ghostArea);
+}
+
+
+//______________________________________________________________________________
+boost::shared_ptr<fastjet::AreaDefinition> JetAreaConfig::areaDefinition() const
+{
+  boost::shared_ptr<fastjet::AreaDefinition> areaDef;
+  switch (mode) {
+  case NoArea:
+    break;
+  case Voronoi:
+    areaDef.reset(new fastjet::AreaDefinition(fastjet::VoronoiAreaSpec(voronoiRfact)));
+    break;
+  case Passive:
+    areaDef.reset(new fastjet::AreaDefinition(fastjet::passive_area,ghostSpec()));
+    break;
+  case Active:
+    areaDef.reset(new fastjet::AreaDefinition(fastjet::active_area,ghostSpec()));
+    break;
+  case ActiveExplicitGhosts:
+    areaDef.reset(new fastjet::AreaDefinition(fastjet::active_area_explicit_ghosts,
+					      ghostSpec()));
+    break;
+  }
+  return areaDef;
+}
+
+
+//______________________________________________________________________________
+JetAreaConfig::Mode JetAreaConfig::parseMode(const string& name)
+{
+  if (name=="none")                 return NoArea;
+  if (name=="voronoi")              return Voronoi;
+  if (name=="passive")              return Passive;
+  if (name=="active")               return Active;
+  if (name=="activeExplicitGhosts") return ActiveExplicitGhosts;
+  throw cms::Exception("InvalidParameter")
+    <<"JetAreaConfig: invalid area mode '"<<name<<"', expected none, voronoi, "
+    <<"passive, active or activeExplicitGhosts\n";
+}
+
+
+//______________________________________________________________________________
+string JetAreaConfig::modeName(Mode m)
+{
+  switch (m) {
+  case NoArea:               return "none";
+  case Voronoi:              return "voronoi";
+  case Passive:              return "passive";
+  case Active:               return "active";
+  case ActiveExplicitGhosts: return "activeExplicitGhosts";
+  }
+  return "unknown";
+}
@@ -0,0 +1,265 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// JetSplittingRecord
+// ------------------
+//
+// see RecoJets/JetAlgorithms/interface/JetSplittingRecord.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/JetSplittingRecord.h"
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+JetSplittingRecord::JetSplittingRecord()
+  : cs_(0)
+  , ghosts_(0)
+{
+}
+
+
+//______________________________________________________________________________
+JetSplittingRecord::JetSplittingRecord(const fastjet::ClusterSequence& cs,
+				       const fastjet::PseudoJet&       jet)
+  : cs_(0)
+  , ghosts_(0)
+{
+  reset(cs,jet);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+void JetSplittingRecord::reset(const fastjet::ClusterSequence& cs,
+			       const fastjet::PseudoJet&       jet)
+{
+  cs_ = &cs;
+  ghosts_ = dynamic_cast<const fastjet::ClusterSequenceAreaBase*>(&cs);
+  if (0!=ghosts_&&!ghosts_->has_explicit_ghosts()) ghosts_ = 0;
+  nodes_.clear();
+  ends_.clear();
+  stack_.clear();
+
+  const vector<fastjet::ClusterSequence::history_element>& hist = cs.history();
+  const vector<fastjet::PseudoJet>&                        jets = cs.jets();
+
+  // depth-first walk, nodes are stored in pre-order so that the subtree of
+  // node i occupies [i,ends_[i]); the second entry of each stack element is
+  // the record index of the child, with the sign telling which parent it is
+  stack_.push_back(make_pair(jet.cluster_hist_index(),0));
+
+  while (!stack_.empty()) {
+
+    int iHist  = stack_.back().first;
+    int iChild = stack_.back().second;
+    stack_.pop_back();
+
+    int iNode = nodes_.size();
+    if      (iChild>0) nodes_[ iChild-1].parent1 = iNode;
+    else if (iChild<0) nodes_[-iChild-1].parent2 = iNode;
+
+    const fastjet::ClusterSequence::history_element& elem = hist[iHist];
+    const fastjet::PseudoJet& pj = jets[elem.jetp_index];
+
+    nodes_.push_back(Node());
+    Node& node       = nodes_.back();
+    node.parent1     = -1;
+    node.parent2     = -1;
+    node.histIndex   = iHist;
+    node.pt          = pj.perp();
+    node.m           = pj.m();
+    node.m2          = pj.m2();
+    node.eta         = pj.eta();
+    node.rapidity    = pj.rapidity();
+    node.phi         = pj.phi();
+    node.dij         = elem.dij;
+    node.maxDijSoFar = elem.max_dij_so_far;
+    node.z           = 0.0;
+    node.deltaR2     = 0.0;
+    node.kt2         = 0.0;
+
+    if (elem.parent1<0||elem.parent2<0) continue;
+    
+    // a pure-ghost subtree is kept as a single leaf, its ghosts are never
+    // walked (nor indexed for the exclusive subjets)
+    if (0!=ghosts_&&ghosts_->is_pure_ghost(pj)) continue;
+
+    // order the parents in decreasing pt, as ClusterSequence::has_parents()
+    int iHist1 = elem.parent1;
+    int iHist2 = elem.parent2;
+    const fastjet::PseudoJet* pj1 = &jets[hist[iHist1].jetp_index];
+    const fastjet::PseudoJet* pj2 = &jets[hist[iHist2].jetp_index];
+    if (pj1->perp2()<pj2->perp2()) { swap(iHist1,iHist2); swap(pj1,pj2); }
+
+    double pt1 = pj1->perp();
+    double pt2 = pj2->perp();
+    node.z       = (pt1+pt2>0.0) ? std::min(pt1,pt2)/(pt1+pt2) : 0.0;
+    node.deltaR2 = pj1->squared_distance(*pj2);
+    node.kt2     = pj1->kt_distance(*pj2);
+
+    stack_.push_back(make_pair(iHist2,-(iNode+1)));
+    stack_.push_back(make_pair(iHist1,  iNode+1 ));
+  }
+
+  // subtree ranges, children always come after their child node
+  ends_.resize(nodes_.size());
+  for (int i=nodes_.size()-1;i>=0;i--)
+    ends_[i] = hasParents(i) ? ends_[nodes_[i].parent2] : i+1;
+}
+
+
+//______________________________________________________________________________
+void JetSplittingRecord::exclusiveSubjets(int i,int nSub,
+					  vector<int>& subjets) const
+{
+  if (nSub<0)
+    throw cms::Exception("InvalidParameter")
+      <<"JetSplittingRecord: negative number of exclusive subjets requested\n";
+  subjets.clear();
+  if (nSub==0) return;
+  fillExclusiveSubjets(i,nSub,-1.0,subjets);
+}
+
+
+//______________________________________________________________________________
+void JetSplittingRecord::exclusiveSubjets(int i,double dcut,
+					  vector<int>& subjets) const
+{
+  fillExclusiveSubjets(i,0,dcut,subjets);
+}
+
+
+//______________________________________________________________________________
+void JetSplittingRecord::exclusiveSubjets(int i,const vector<int>& nSubs,
+					  vector<vector<int> >& subjets) const
+{
+  subjets.resize(nSubs.size());
+  
+  // the recombinations are undone in the same order for all multiplicities,
+  // so a single pass serves them all, smallest multiplicity first
+  vector<int> order(nSubs.size());
+  for (unsigned k=0;k<nSubs.size();k++) {
+    if (nSubs[k]<0)
+      throw cms::Exception("InvalidParameter")
+	<<"JetSplittingRecord: negative number of exclusive subjets requested\n";
+    order[k] = k;
+  }
+  sort(order.begin(),order.end(),NSubLess(nSubs));
+  
+  vector<int> current(1,i);
+  size_t      nHeap(1);
+  unsigned    k(0);
+  for (;k<order.size()&&nSubs[order[k]]==0;k++) subjets[order[k]].clear();
+  while (k<order.size()) {
+    for (;k<order.size()&&nSubs[order[k]]==(int)current.size();k++) {
+      subjets[order[k]] = current;
+      sort(subjets[order[k]].begin(),subjets[order[k]].end(),HistIndexLess(nodes_));
+    }
+    if (k<order.size()&&!undoNextMerge(current,nHeap,-1.0)) break;
+  }
+  
+  // multiplicities above the number of constituents get all of them
+  sort(current.begin(),current.end(),HistIndexLess(nodes_));
+  for (;k<order.size();k++) subjets[order[k]] = current;
+}
+
+
+//______________________________________________________________________________
+int JetSplittingRecord::nExclusiveSubjets(int i,double dcut) const
+{
+  vector<int> subjets;
+  fillExclusiveSubjets(i,0,dcut,subjets);
+  return subjets.size();
+}
+
+
+//______________________________________________________________________________
+void JetSplittingRecord::fillExclusiveSubjets(int i,int nMax,double dcut,
+					      vector<int>& subjets) const
+{
+  // undo the recombinations inside the subtree of i, latest first, until
+  // either nMax subjets are reached (nMax==0: no limit) or dcut is passed
+  subjets.assign(1,i);
+  size_t nHeap(1);
+  while ((nMax==0||(int)subjets.size()<nMax)&&undoNextMerge(subjets,nHeap,dcut));
+  
+  // same (history) order as ClusterSequence::exclusive_subjets()
+  sort(subjets.begin(),subjets.end(),HistIndexLess(nodes_));
+}
+
+
+//______________________________________________________________________________
+bool JetSplittingRecord::undoNextMerge(vector<int>& subjets,size_t& nHeap,
+				       double dcut) const
+{
+  // subjets[0,nHeap) is a heap of the subjets which may still be split,
+  // latest recombination on top; subjets[nHeap,end) are leaves, which
+  // are moved there as they reach the top
+  HistIndexLess less(nodes_);
+  while (nHeap>0) {
+    int iTop = subjets.front();
+    if (hasParents(iTop)&&nodes_[iTop].maxDijSoFar<=dcut) return false;
+    pop_heap(subjets.begin(),subjets.begin()+nHeap,less);
+    if (!hasParents(iTop)) { nHeap--; continue; }
+    
+    subjets[nHeap-1] = nodes_[iTop].parent1;
+    push_heap(subjets.begin(),subjets.begin()+nHeap,less);
+    subjets.push_back(nodes_[iTop].parent2);
+    swap(subjets[nHeap],subjets.back());
+    push_heap(subjets.begin(),subjets.begin()+(++nHeap),less);
+    return true;
+  }
+  return false;
+}
+
+
+//______________________________________________________________________________
+void JetSplittingRecord::constituents(int i,vector<int>& indices) const
+{
+  indices.clear();
+  int k = i;
+  while (k<ends_[i]) {
+    if (0!=ghosts_&&ghosts_->is_pure_ghost(pseudoJet(k))) { k = ends_[k]; continue; }
+    if (!hasParents(k)) {
+      int userIndex = pseudoJet(k).user_index();
+      if (userIndex>=0) indices.push_back(userIndex);
+    }
+    k++;
+  }
+}
+
+
+//______________________________________________________________________________
+double JetSplittingRecord::deltaR(int i) const
+{
+  return std::sqrt(nodes_[i].deltaR2);
+}
+
+
+//______________________________________________________________________________
+double JetSplittingRecord::kt(int i) const
+{
+  return std::sqrt(nodes_[i].kt2);
+}
+
+
+//______________________________________________________________________________
+const fastjet::PseudoJet& JetSplittingRecord::pseudoJet(int i) const
+{
+  return cs_->jets()[cs_->history()[nodes_[i].histIndex].jetp_index];
+}
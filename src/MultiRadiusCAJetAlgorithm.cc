@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// MultiRadiusCAJetAlgorithm
+// -------------------------
+//
+// see RecoJets/JetAlgorithms/interface/MultiRadiusCAJetAlgorithm.h
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/MultiRadiusCAJetAlgorithm.h"
+
+#include "FWCore/Utilities/interface/Exception.h"
+
+#include <cmath>
+#include <algorithm>
+
+
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// construction / destruction
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+MultiRadiusCAJetAlgorithm::MultiRadiusCAJetAlgorithm(const vector<double>& radii,
+						     double jetPtMin)
+  : radii_(radii)
+  , jetPtMin_(jetPtMin)
+{
+  if (radii_.empty())
+    throw cms::Exception("InvalidParameter")
+      <<"MultiRadiusCAJetAlgorithm requires at least one radius\n";
+  for (unsigned i=0;i<radii_.size();i++)
+    if (radii_[i]<=0.0)
+      throw cms::Exception("InvalidParameter")
+	<<"MultiRadiusCAJetAlgorithm: invalid radius "<<radii_[i]<<"\n";
+
+  double rMax = *max_element(radii_.begin(),radii_.end());
+  fjJetDef_ = fastjet::JetDefinition(fastjet::cambridge_algorithm,rMax);
+}
+
+
+//______________________________________________________________________________
+MultiRadiusCAJetAlgorithm::~MultiRadiusCAJetAlgorithm()
+{
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// implementation of member functions
+////////////////////////////////////////////////////////////////////////////////
+
+//______________________________________________________________________________
+void MultiRadiusCAJetAlgorithm::run(const vector<fastjet::PseudoJet>& inputs,
+				    vector<vector<fastjet::PseudoJet> >& jets,
+				    boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq) const
+{
+  fjClusterSeq = boost::shared_ptr<fastjet::ClusterSequence>
+    (new fastjet::ClusterSequence(inputs,fjJetDef_));
+  run(*fjClusterSeq,jets);
+}
+
+
+//______________________________________________________________________________
+void MultiRadiusCAJetAlgorithm::run(const fastjet::ClusterSequence& cs,
+				    vector<vector<fastjet::PseudoJet> >& jets) const
+{
+  jets.resize(radii_.size());
+  for (unsigned i=0;i<radii_.size();i++) inclusiveJets(cs,radii_[i],jets[i]);
+}
+
+
+//______________________________________________________________________________
+void MultiRadiusCAJetAlgorithm::inclusiveJets(const fastjet::ClusterSequence& cs,
+					      double r,
+					      vector<fastjet::PseudoJet>& jets) const
+{
+  jets.clear();
+
+  const fastjet::JetDefinition& jetDef = cs.jet_def();
+  if (jetDef.jet_algorithm()!=fastjet::cambridge_algorithm)
+    throw cms::Exception("InvalidClusterSequence")
+      <<"MultiRadiusCAJetAlgorithm: cluster sequence must be Cambridge/Aachen, "
+      <<"found "<<jetDef.description()<<"\n";
+  if (r>jetDef.R())
+    throw cms::Exception("InvalidParameter")
+      <<"MultiRadiusCAJetAlgorithm: R="<<r<<" exceeds the clustering radius "
+      <<jetDef.R()<<"\n";
+
+  const vector<fastjet::ClusterSequence::history_element>& hist = cs.history();
+  const vector<fastjet::PseudoJet>&                        pjs  = cs.jets();
+  const double r2 = r*r;
+
+  // the recombinations with DeltaR<r form a prefix of the C/A history; find
+  // the first one that is not part of it. The pair distance is evaluated
+  // from the parents' (rapidity,phi) exactly as the fastjet N^2 strategies
+  // do, so that the r<R jets match a clustering with radius r.
+  unsigned nInitial = cs.n_particles();
+  unsigned iStop    = nInitial;
+  for (;iStop<hist.size();iStop++) {
+    const fastjet::ClusterSequence::history_element& elem = hist[iStop];
+    if (elem.parent2<0) break; // beam recombination
+    const fastjet::PseudoJet& pj1 = pjs[hist[elem.parent1].jetp_index];
+    const fastjet::PseudoJet& pj2 = pjs[hist[elem.parent2].jetp_index];
+    double dphi = std::abs(pj1.phi_02pi()-pj2.phi_02pi());
+    if (dphi>fastjet::pi) dphi = fastjet::twopi-dphi;
+    double deta = pj1.rap()-pj2.rap();
+    if (dphi*dphi+deta*deta>=r2) break;
+  }
+
+  // the r-jets are all objects present at that point of the history
+  for (unsigned i=0;i<iStop;i++) {
+    int iChild = hist[i].child;
+    if (iChild>=0&&iChild<(int)iStop) continue;
+    const fastjet::PseudoJet& pj = pjs[hist[i].jetp_index];
+    if (pj.perp()>=jetPtMin_) jets.push_back(pj);
+  }
+
+  jets = fastjet::sorted_by_pt(jets);
+}
@@ -11,6 +11,28 @@
 
 using namespace fastjet;
 
+PrunedRecombiner::PrunedRecombiner(const PrunedRecombiner & other) :
+	JetDefinition::Recombiner(other),
+	_zcut(other._zcut), _Rcut(other._Rcut), _recombiner(other._recombiner),
+	_default_recombiner(other._default_recombiner)
+{
+	if (other._recombiner == &other._default_recombiner)
+		_recombiner = &_default_recombiner;
+}
+
+PrunedRecombiner & PrunedRecombiner::operator=(const PrunedRecombiner & other)
+{
+	if (this != &other) {
+		_zcut = other._zcut;
+		_Rcut = other._Rcut;
+		_pruned_pseudojets.clear();
+		_default_recombiner = other._default_recombiner;
+		_recombiner = (other._recombiner == &other._default_recombiner) ?
+			&_default_recombiner : other._recombiner;
+	}
+	return *this;
+}
+
 std::string PrunedRecombiner::description() const
 {
 	std::ostringstream s;
@@ -1,95 +1,242 @@
 #include "RecoJets/JetAlgorithms/interface/SubJetAlgorithm.h"
 #include "FWCore/MessageLogger/interface/MessageLogger.h"
 #include "FWCore/Utilities/interface/Exception.h"
+#include "RecoJets/JetAlgorithms/interface/JetSplittingRecord.h"
 #include "fastjet/ClusterSequenceArea.hh"
+#include "fastjet/Error.hh"
+
+#include <algorithm>
+#include <functional>
+#include <sstream>
 
 using namespace std;
 using namespace edm;
 
 void SubJetAlgorithm::set_zcut(double z){
     zcut_ = z;
+    makePrunePlugin();
 }
 
 void SubJetAlgorithm::set_rcut_factor(double r){
     rcut_factor_ = r;
+    makePrunePlugin();
+}
+
+//for actual jet clustering, either the pruned or the original version is used.
+//For the pruned version, a new jet definition using the PrunedRecombPlugin is required.
+//It is built once per set of parameters and reused for every event: the plugin
+//keeps no per-event state (the unpruned sequence is in the pruned sequence's extras).
+//The jet definition owns the plugin, and every ClusterSequence (e.g. in a
+//ClusterSequenceCache) shares that ownership through its copy of the definition,
+//so a replaced plugin lives exactly as long as the sequences clustered with it.
+void SubJetAlgorithm::makePrunePlugin(){
+  fjPruneJetDef_ = boost::shared_ptr<fastjet::JetDefinition>
+    ( new fastjet::JetDefinition( new fastjet::FastPrunePlugin(*fjJetDefinition_,
+							       *fjJetDefinition_,
+							       zcut_,
+							       rcut_factor_) ) );
+  fjPruneJetDef_->delete_plugin_when_unused();
 }
 
 
 //  Run the algorithm
 //  ------------------
 void SubJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles, 
-			   vector<CompoundPseudoJet> & hardjetsOutput ) {
+			   vector<CompoundPseudoJet> & hardjetsOutput,
+			   ClusterSequenceCache * cache ) {
+
+  CompoundPseudoJetCollection hardjetsCollection( storeFourVectors_ ?
+						  CompoundPseudoJetCollection::FourVectors :
+						  CompoundPseudoJetCollection::PseudoJets );
+  run( cell_particles, hardjetsCollection, cache );
+  hardjetsCollection.toCompoundPseudoJets( hardjetsOutput );
+}
+
+
+//  Run the algorithm, filling a flat collection
+//  ---------------------------------------------
+void SubJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles, 
+			   CompoundPseudoJetCollection & hardjetsOutput,
+			   ClusterSequenceCache * cache ) {
+
+  findJets( cell_particles, hardjetsOutput, 0, 0, cache );
+}
+
+
+//  Run the algorithm, also returning the unpruned jets
+//  ----------------------------------------------------
+void SubJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles, 
+			   vector<CompoundPseudoJet> & hardjetsOutput,
+			   vector<fastjet::PseudoJet> & unprunedJets,
+			   vector<double> & unprunedAreas,
+			   ClusterSequenceCache * cache ) {
+
+  CompoundPseudoJetCollection hardjetsCollection( storeFourVectors_ ?
+						  CompoundPseudoJetCollection::FourVectors :
+						  CompoundPseudoJetCollection::PseudoJets );
+  findJets( cell_particles, hardjetsCollection, &unprunedJets, &unprunedAreas, cache );
+  hardjetsCollection.toCompoundPseudoJets( hardjetsOutput );
+}
 
-  //for actual jet clustering, either the pruned or the original version is used.
-  //For the pruned version, a new jet definition using the PrunedRecombPlugin is required:
-  fastjet::FastPrunePlugin PRplugin(*fjJetDefinition_,
-				    *fjJetDefinition_,
-				    zcut_,
-				    rcut_factor_);
-  fastjet::JetDefinition pjetdef(&PRplugin);
 
+void SubJetAlgorithm::run( const vector<fastjet::PseudoJet> & cell_particles, 
+			   CompoundPseudoJetCollection & hardjetsOutput,
+			   vector<fastjet::PseudoJet> & unprunedJets,
+			   vector<double> & unprunedAreas,
+			   ClusterSequenceCache * cache ) {
 
+  findJets( cell_particles, hardjetsOutput, &unprunedJets, &unprunedAreas, cache );
+}
+
+
+//  Do the actual work
+//  ------------------
+void SubJetAlgorithm::findJets( const vector<fastjet::PseudoJet> & cell_particles, 
+				CompoundPseudoJetCollection & hardjetsOutput,
+				vector<fastjet::PseudoJet> * unprunedJets,
+				vector<double> * unprunedAreas,
+				ClusterSequenceCache * cache ) {
 
   // cluster the jets with the jet definition jetDef:
   // run algorithm
-  boost::shared_ptr<fastjet::ClusterSequence> fjClusterSeq;
-  if ( !doAreaFastjet_ ) {
-    fjClusterSeq = 
-      boost::shared_ptr<fastjet::ClusterSequence>( new fastjet::ClusterSequence( cell_particles, 
-  										 pjetdef ) );
-  } else if (voronoiRfact_ <= 0) {
-    fjClusterSeq = 
-      boost::shared_ptr<fastjet::ClusterSequence>( new fastjet::ClusterSequenceActiveArea( cell_particles, 
-  											   pjetdef , 
-  											   *fjActiveArea_ ) );
-  } else {
-    fjClusterSeq = 
-      boost::shared_ptr<fastjet::ClusterSequence>( new fastjet::ClusterSequenceVoronoiArea( cell_particles, 
-  											    pjetdef , 
-  											    fastjet::VoronoiAreaSpec(voronoiRfact_) ) );
+  boost::shared_ptr<fastjet::AreaDefinition> fjAreaDefinition;
+  if ( doAreaFastjet_ && voronoiRfact_ <= 0 ) {
+    fjAreaDefinition = 
+      boost::shared_ptr<fastjet::AreaDefinition>( new fastjet::AreaDefinition( fastjet::active_area, 
+									       *fjActiveArea_ ) );
+  } else if ( doAreaFastjet_ ) {
+    fjAreaDefinition = 
+      boost::shared_ptr<fastjet::AreaDefinition>( new fastjet::AreaDefinition( fastjet::VoronoiAreaSpec(voronoiRfact_) ) );
   }
 
+  boost::shared_ptr<fastjet::ClusterSequence> fjClusterSeq = (cache != 0) ?
+    cache->get( cell_particles, *fjPruneJetDef_, fjAreaDefinition.get() ) :
+    ClusterSequenceCache::cluster( cell_particles, *fjPruneJetDef_, fjAreaDefinition.get() );
+
+  // active and Voronoi areas are both available through the area base class;
+  // with lazy areas, the collection computes them on first access (not for
+  // FourVectors storage, where the collection must not keep the sequence)
+  bool lazyAreas = doAreaFastjet_ && lazyAreas_ &&
+    hardjetsOutput.storage() == CompoundPseudoJetCollection::PseudoJets;
+  if ( lazyAreas ) hardjetsOutput.setAreaSequence( fjClusterSeq );
+  const fastjet::ClusterSequenceAreaBase * fjClusterSeqArea = (doAreaFastjet_ && !lazyAreas) ?
+    dynamic_cast<const fastjet::ClusterSequenceAreaBase *>( fjClusterSeq.get() ) : 0;
+
   vector<fastjet::PseudoJet> inclusiveJets = fjClusterSeq->inclusive_jets(ptMin_);
 
-  // These will store the indices of each subjet that 
-  // are present in each jet
-  vector<vector<int> > indices(inclusiveJets.size());
-  // Loop over inclusive jets, attempt to find substructure
-  vector<fastjet::PseudoJet>::iterator jetIt = inclusiveJets.begin();
-  for ( ; jetIt != inclusiveJets.end(); ++jetIt ) {
-    //decompose into requested number of subjets:
-    vector<fastjet::PseudoJet> subjets = fjClusterSeq->exclusive_subjets(*jetIt, nSubjets_);
-    //create the subjets objects to put into the "output" objects
-    vector<CompoundPseudoSubJet>  subjetsOutput;
-    std::vector<fastjet::PseudoJet>::const_iterator itSubJetBegin = subjets.begin(),
-      itSubJet = itSubJetBegin, itSubJetEnd = subjets.end();
-    for (; itSubJet != itSubJetEnd; ++itSubJet ){
-      // Get the transient subjet constituents from fastjet
-      vector<fastjet::PseudoJet> subjetFastjetConstituents = fjClusterSeq->constituents( *itSubJet );
-      // Get the indices of the constituents:
-      vector<int> constituents;
-      vector<fastjet::PseudoJet>::const_iterator fastSubIt = subjetFastjetConstituents.begin(),
-	transConstEnd = subjetFastjetConstituents.end();
-      for ( ; fastSubIt != transConstEnd; ++fastSubIt ) {
-	if (fastSubIt->user_index() >= 0) {
-	  constituents.push_back( fastSubIt->user_index() );
-	}
+  // constituent -> owner lookups cover all inputs (if enabled)
+  hardjetsOutput.resizeOwnerIndex( cell_particles.size() );
+
+  // The plugin's extras map every input to its unpruned jet. With Voronoi
+  // areas, the area of an unpruned jet is the sum of the Voronoi cells of its
+  // inputs. Active areas are not additive over the inputs (the ghosts merged
+  // into composite jets belong to no input): the inputs are clustered once
+  // more with the unpruned definition and the area definition (through the
+  // cache, if given), and each jet of that sequence gives its area to the
+  // unpruned jet of its first real constituent. The ghosts do not change the
+  // real content of the jets, so both sequences have the same jets.
+  const fastjet::FastPrunePlugin::Extras * fjPruneExtras = (unprunedJets != 0) ?
+    dynamic_cast<const fastjet::FastPrunePlugin::Extras *>( fjClusterSeq->extras() ) : 0;
+  vector<double> fjUnprunedAreas;
+  if ( fjPruneExtras != 0 && doAreaFastjet_ && voronoiRfact_ > 0 ) {
+    const fastjet::ClusterSequenceAreaBase * fjAreaSeq =
+      dynamic_cast<const fastjet::ClusterSequenceAreaBase *>( fjClusterSeq.get() );
+    fjUnprunedAreas.assign( fjPruneExtras->unpruned_jets().size(), 0.0 );
+    for ( unsigned i = 0; fjAreaSeq != 0 && i < fjClusterSeq->n_particles(); ++i ) {
+      int iUnpruned = fjPruneExtras->unpruned_jet_index(i);
+      if ( iUnpruned >= 0 ) fjUnprunedAreas[iUnpruned] += fjAreaSeq->area( fjClusterSeq->jets()[i] );
+    }
+  } else if ( fjPruneExtras != 0 && doAreaFastjet_ ) {
+    boost::shared_ptr<fastjet::ClusterSequence> fjUnprunedSeq = (cache != 0) ?
+      cache->get( cell_particles, *fjJetDefinition_, fjAreaDefinition.get() ) :
+      ClusterSequenceCache::cluster( cell_particles, *fjJetDefinition_, fjAreaDefinition.get() );
+    const fastjet::ClusterSequenceAreaBase * fjAreaSeq =
+      dynamic_cast<const fastjet::ClusterSequenceAreaBase *>( fjUnprunedSeq.get() );
+    fjUnprunedAreas.assign( fjPruneExtras->unpruned_jets().size(), 0.0 );
+    vector<fastjet::PseudoJet> fjAreaJets = fjUnprunedSeq->inclusive_jets();
+    for ( unsigned i = 0; fjAreaSeq != 0 && i < fjAreaJets.size(); ++i ) {
+      vector<fastjet::PseudoJet> fjConstituents = fjUnprunedSeq->constituents( fjAreaJets[i] );
+      for ( unsigned k = 0; k < fjConstituents.size(); ++k ) {
+	int iInput = fjConstituents[k].cluster_hist_index();
+	if ( iInput < 0 || iInput >= (int)cell_particles.size() ) continue; // ghost
+	int iUnpruned = fjPruneExtras->unpruned_jet_index( iInput );
+	if ( iUnpruned >= 0 ) fjUnprunedAreas[iUnpruned] = fjAreaSeq->area( fjAreaJets[i] );
+	break;
       }
+    }
+  }
 
-      double subJetArea = (doAreaFastjet_) ?
-	dynamic_cast<fastjet::ClusterSequenceActiveArea&>(*fjClusterSeq).area(*itSubJet) : 0.0;
+  // Loop over inclusive jets, attempt to find substructure
+  JetSplittingRecord record;
+  vector<int> subjetNodes;
+  vector<int> constituents;
+  // the inclusive jets are not sorted: areas go to jets at or above the pt
+  // of the n-th leading jet
+  double areaPt2Min = 0.0;
+  if ( nAreaJets_ > 0 && inclusiveJets.size() > nAreaJets_ ) {
+    vector<double> pt2s;
+    pt2s.reserve( inclusiveJets.size() );
+    for ( unsigned i = 0; i < inclusiveJets.size(); ++i ) pt2s.push_back( inclusiveJets[i].perp2() );
+    nth_element( pt2s.begin(), pt2s.begin() + (nAreaJets_-1), pt2s.end(), greater<double>() );
+    areaPt2Min = pt2s[nAreaJets_-1];
+  }
 
+  vector<fastjet::PseudoJet>::iterator jetIt = inclusiveJets.begin();
+  for ( ; jetIt != inclusiveJets.end(); ++jetIt ) {
+    bool withArea = ( jetIt->perp2() >= areaPt2Min );
+
+    //decompose into requested number of subjets, using the jet's merging index
+    //instead of letting the ClusterSequence walk the history for each request:
+    record.reset(*fjClusterSeq, *jetIt);
+    record.exclusiveSubjets(record.root(), nSubjets_, subjetNodes);
+    if ( static_cast<int>(subjetNodes.size()) < nSubjets_ ) {
+      ostringstream err;
+      err << "Requested " << nSubjets_ << " exclusive subjets, but there were only " 
+	  << subjetNodes.size() << " particles in the jet";
+      throw fastjet::Error(err.str());
+    }
 
-      // Make a CompoundPseudoSubJet object to hold this subjet and the indices of its constituents
-      subjetsOutput.push_back( CompoundPseudoSubJet( *itSubJet, subJetArea, constituents ) );
+    // The unpruned jet is the one containing any of the jet's inputs
+    if ( unprunedJets != 0 ) {
+      int iUnpruned = -1;
+      if ( fjPruneExtras != 0 ) {
+	unsigned iLeaf = record.root();
+	while ( record.hasParents(iLeaf) ) ++iLeaf;
+	iUnpruned = fjPruneExtras->unpruned_jet_index( record[iLeaf].histIndex );
+      }
+      fastjet::PseudoJet unprunedJet(0.0, 0.0, 0.0, 0.0);
+      if ( iUnpruned >= 0 ) unprunedJet = fjPruneExtras->unpruned_jets()[iUnpruned];
+      if ( storeFourVectors_ )
+	unprunedJet = fastjet::PseudoJet( unprunedJet.px(), unprunedJet.py(), unprunedJet.pz(), unprunedJet.E() );
+      unprunedJets->push_back( unprunedJet );
+      unprunedAreas->push_back( (iUnpruned >= 0 && !fjUnprunedAreas.empty()) ?
+				fjUnprunedAreas[iUnpruned] : 0.0 );
+    }
 
+    // Add this hard jet, then the subjets that make it up
+    if ( lazyAreas && withArea ) {
+      hardjetsOutput.addJetLazyArea( *jetIt );
+    } else {
+      double fatJetArea = (fjClusterSeqArea != 0 && withArea) ?
+	fjClusterSeqArea->area(*jetIt) : 0.0;
+      hardjetsOutput.addJet( *jetIt, fatJetArea );
     }
 
+    for ( vector<int>::const_iterator iNode = subjetNodes.begin(); iNode != subjetNodes.end(); ++iNode ) {
+      const fastjet::PseudoJet & subjet = record.pseudoJet(*iNode);
 
-    double fatJetArea = (doAreaFastjet_) ?
-      dynamic_cast<fastjet::ClusterSequenceActiveArea&>(*fjClusterSeq).area(*jetIt) : 0.0;
+      if ( lazyAreas && withArea ) {
+	hardjetsOutput.addSubJetLazyArea( subjet );
+      } else {
+	double subJetArea = (fjClusterSeqArea != 0 && withArea) ?
+	  fjClusterSeqArea->area(subjet) : 0.0;
+	hardjetsOutput.addSubJet( subjet, subJetArea );
+      }
 
-    // Make a CompoundPseudoJet object to hold this hard jet, and the subjets that make it up
-    hardjetsOutput.push_back( CompoundPseudoJet( *jetIt,fatJetArea,subjetsOutput));
+      // Store the indices of the subjet constituents, read off the jet's
+      // record (ghosts are skipped without being scanned)
+      record.constituents( *iNode, constituents );
+      hardjetsOutput.addConstituents( constituents );
+    }
   }
 }
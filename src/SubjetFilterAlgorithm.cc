@@ -17,9 +17,11 @@
 
 
 #include "RecoJets/JetAlgorithms/interface/SubjetFilterAlgorithm.h"
+#include "RecoJets/JetAlgorithms/interface/JetSplittingRecord.h"
 
 #include <fastjet/ClusterSequenceArea.hh>
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -29,7 +31,23 @@
 using namespace std;
 
 
-ostream & operator<<(ostream & ostr, fastjet::PseudoJet & jet);
+ostream & operator<<(ostream & ostr, const fastjet::PseudoJet & jet);
+
+
+namespace {
+  /// order record nodes in decreasing pt, as fastjet::sorted_by_pt()
+  struct NodePtGreater {
+    NodePtGreater(const JetSplittingRecord& record) : record_(record) {}
+    bool operator()(int i,int j) const { return record_[i].pt>record_[j].pt; }
+    const JetSplittingRecord& record_;
+  };
+  
+  /// plain PseudoJet (without cluster sequence) of a stored 4-vector
+  fastjet::PseudoJet fourVectorJet(const CompoundPseudoJetCollection::FourVector& p4)
+  {
+    return fastjet::PseudoJet(p4.px,p4.py,p4.pz,p4.e);
+  }
+}
 
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -60,43 +78,39 @@ SubjetFilterAlgorithm::SubjetFilterAlgorithm(const std::string& moduleLabel,
   , massDropCut_(massDropCut)
   , asymmCut2_(asymmCut*asymmCut)
   , asymmCutLater_(asymmCutLater)
-  , doAreaFastjet_(doAreaFastjet)
-  , ghostEtaMax_(ghostEtaMax)
-  , activeAreaRepeats_(activeAreaRepeats)
-  , ghostArea_(ghostArea)
+  , areaConfig_((doAreaFastjet) ? JetAreaConfig::ActiveExplicitGhosts : JetAreaConfig::NoArea,
+		ghostEtaMax,activeAreaRepeats,ghostArea)
   , verbose_(verbose)
-  , nevents_(0)
-  , ntotal_(0)
-  , nfound_(0)
-  , fjJetDef_(0)
-  , fjAreaDef_(0)
+  , storeFourVectors_(false)
+  , lazyAreas_(false)
+  , nAreaJets_(0)
 {
+  nevents_           = 0;
+  ntotal_            = 0;
+  nfound_            = 0;
+  clusteringTimeNs_  = 0;
+  filteringTimeNs_   = 0;
+  
   // FASTJET JET DEFINITION
   if (jetAlgorithm=="CambridgeAachen"||jetAlgorithm_=="ca")
-    fjJetDef_=new fastjet::JetDefinition(fastjet::cambridge_algorithm,rParam_);
+    fjJetDef_.reset(new fastjet::JetDefinition(fastjet::cambridge_algorithm,rParam_));
   else if (jetAlgorithm=="AntiKt"||jetAlgorithm_=="ak")
-    fjJetDef_=new fastjet::JetDefinition(fastjet::antikt_algorithm,rParam_);
+    fjJetDef_.reset(new fastjet::JetDefinition(fastjet::antikt_algorithm,rParam_));
   else if (jetAlgorithm=="Kt"||jetAlgorithm_=="kt")
-    fjJetDef_=new fastjet::JetDefinition(fastjet::kt_algorithm,rParam_);
+    fjJetDef_.reset(new fastjet::JetDefinition(fastjet::kt_algorithm,rParam_));
   else
     throw cms::Exception("InvalidJetAlgo")
       <<"Jet Algorithm for SubjetFilterAlgorithm is invalid: "
       <<jetAlgorithm_<<", use (ca|CambridgeAachen)|(Kt|kt)|(AntiKt|ak)"<<endl;
 
   // FASTJET AREA DEFINITION
-  if (doAreaFastjet_) {
-    fastjet::GhostedAreaSpec ghostSpec(ghostEtaMax_,activeAreaRepeats_,ghostArea_);
-    fjAreaDef_=new fastjet::AreaDefinition(fastjet::active_area_explicit_ghosts,
-					   ghostSpec); 
-  }
+  fjAreaDef_ = areaConfig_.areaDefinition();
 }
 
 
 //______________________________________________________________________________
 SubjetFilterAlgorithm::~SubjetFilterAlgorithm()
 {
-  if (0!=fjJetDef_)  delete fjJetDef_;
-  if (0!=fjAreaDef_) delete fjAreaDef_;
 }
   
 
@@ -107,154 +121,399 @@ SubjetFilterAlgorithm::~SubjetFilterAlgorithm()
 //______________________________________________________________________________
 void SubjetFilterAlgorithm::run(const std::vector<fastjet::PseudoJet>& fjInputs, 
 				std::vector<CompoundPseudoJet>& fjJets,
-				const edm::EventSetup& iSetup)
+				const edm::EventSetup& iSetup) const
+{
+  boost::shared_ptr<fastjet::ClusterSequence> fjClusterSeq;
+  run(fjInputs,fjJets,fjClusterSeq);
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::run(const std::vector<fastjet::PseudoJet>& fjInputs, 
+				std::vector<CompoundPseudoJet>& fjJets,
+				boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq,
+				ClusterSequenceCache* cache) const
+{
+  CompoundPseudoJetCollection fjJetCollection(storeFourVectors_ ?
+					      CompoundPseudoJetCollection::FourVectors :
+					      CompoundPseudoJetCollection::PseudoJets);
+  run(fjInputs,fjJetCollection,fjClusterSeq,cache);
+  fjJetCollection.toCompoundPseudoJets(fjJets);
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::run(const std::vector<fastjet::PseudoJet>& fjInputs, 
+				CompoundPseudoJetCollection& fjJets,
+				boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq,
+				ClusterSequenceCache* cache) const
+{
+  unsigned long iEvent = nevents_.fetch_and_increment()+1;
+  
+  if (verbose_) cout<<endl<<iEvent<<". EVENT"<<endl;
+  
+  tbb::tick_count t0 = tbb::tick_count::now();
+  fjClusterSeq = cluster(fjInputs,cache);
+  tbb::tick_count t1 = tbb::tick_count::now();
+  
+  // constituent -> owner lookups cover all inputs (if enabled)
+  fjJets.resizeOwnerIndex(fjInputs.size());
+  
+  // areas are computed by the collection, on first access
+  if (areaConfig_.hasArea()&&lazyAreas_&&
+      fjJets.storage()==CompoundPseudoJetCollection::PseudoJets)
+    fjJets.setAreaSequence(fjClusterSeq);
+  
+  unsigned nBefore = fjJets.size();
+  filterJets(*fjClusterSeq,jetPtMin_,fjJets);
+  tbb::tick_count t2 = tbb::tick_count::now();
+  
+  unsigned nFound(0);
+  for (unsigned i=nBefore;i<fjJets.size();i++)
+    if (fjJets.nSubJets(i)>3) nFound++;
+  ntotal_           += fjJets.size()-nBefore;
+  nfound_           += nFound;
+  clusteringTimeNs_ += nanoseconds(t1-t0);
+  filteringTimeNs_  += nanoseconds(t2-t1);
+  
+  if (verbose_) cout<<endl<<fjJets.size()<<" FATJETS written\n"<<endl;
+  
+  return;
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::run(const fastjet::ClusterSequence& cs,
+				CompoundPseudoJetCollection& fjJets) const
+{
+  filterJets(cs,jetPtMin_,fjJets);
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::setAreaConfig(const JetAreaConfig& areaConfig)
+{
+  areaConfig_ = areaConfig;
+  fjAreaDef_  = areaConfig_.areaDefinition();
+  if (!areaConfig_.hasExplicitGhosts()) ghostPool_.reset();
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::setGhostTemplates(unsigned nTemplates,int seed)
+{
+  if (!areaConfig_.hasExplicitGhosts()) return;
+  ghostPool_.reset(new GhostTemplatePool(areaConfig_.ghostSpec(),nTemplates,seed));
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::runScan(const std::vector<fastjet::PseudoJet>& fjInputs,
+				    const std::vector<Parameters>& parameters,
+				    std::vector<CompoundPseudoJetCollection>& fjJets,
+				    boost::shared_ptr<fastjet::ClusterSequence>& fjClusterSeq,
+				    ClusterSequenceCache* cache) const
+{
+  fjClusterSeq = cluster(fjInputs,cache);
+  
+  fjJets.resize(parameters.size());
+  for (size_t i=0;i<fjJets.size();i++) {
+    fjJets[i].resizeOwnerIndex(fjInputs.size());
+    if (areaConfig_.hasArea()&&lazyAreas_&&
+	fjJets[i].storage()==CompoundPseudoJetCollection::PseudoJets)
+      fjJets[i].setAreaSequence(fjClusterSeq);
+  }
+  
+  runScan(*fjClusterSeq,parameters,fjJets);
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::runScan(const fastjet::ClusterSequence& cs,
+				    const std::vector<Parameters>& parameters,
+				    std::vector<CompoundPseudoJetCollection>& fjJets) const
 {
-  nevents_++;
+  fjJets.resize(parameters.size());
+  if (parameters.empty()) return;
   
-  if (verbose_) cout<<endl<<nevents_<<". EVENT"<<endl;
+  vector<CompoundPseudoJetCollection*> fjJetsPtrs;
+  for (size_t i=0;i<fjJets.size();i++) fjJetsPtrs.push_back(&fjJets[i]);
+  filterJets(cs,jetPtMin_,parameters,fjJetsPtrs);
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::runScaleVariations(const fastjet::ClusterSequence& cs,
+					       const std::vector<double>& scales,
+					       std::vector<std::vector<CompoundPseudoJet> >& fjJets) const
+{
+  fjJets.resize(scales.size());
+  if (scales.empty()) return;
   
-  fastjet::ClusterSequence* cs = (doAreaFastjet_) ?
-    new fastjet::ClusterSequenceArea(fjInputs,*fjJetDef_,*fjAreaDef_) :
-    new fastjet::ClusterSequence    (fjInputs,*fjJetDef_);
+  double scaleMax(0.0);
+  for (size_t i=0;i<scales.size();i++) {
+    if (scales[i]<=0.0)
+      throw cms::Exception("InvalidParameter")
+	<<"SubjetFilterAlgorithm: invalid momentum scale "<<scales[i]<<endl;
+    scaleMax = std::max(scaleMax,scales[i]);
+  }
+  
+  // the mass-drop, asymmetry and filtering decisions are ratios of momenta
+  // and angles, so only the fat jet pt threshold depends on the scale: tag
+  // every fat jet above the lowest (scaled) threshold once, then select and
+  // scale for each variation. nFatMax_ selects the leading jets, whose order
+  // does not depend on the scale either.
+  // with FourVectors storage, the scaled jets do not refer to cs either
+  CompoundPseudoJetCollection fjAllJets(storeFourVectors_ ?
+					CompoundPseudoJetCollection::FourVectors :
+					CompoundPseudoJetCollection::PseudoJets);
+  filterJets(cs,jetPtMin_/scaleMax,fjAllJets);
+  
+  vector<int> constituents;
+  for (size_t iScale=0;iScale<scales.size();iScale++) {
+    double scale = scales[iScale];
+    fjJets[iScale].clear();
+    for (unsigned iFat=0;iFat<fjAllJets.size();iFat++) {
+      fastjet::PseudoJet hardJet = storeFourVectors_ ?
+	fourVectorJet(fjAllJets.hardJetP4(iFat)) : fjAllJets.hardJet(iFat);
+      if (hardJet.perp()*scale<jetPtMin_) break;
+      vector<CompoundPseudoSubJet> subJets;
+      for (unsigned iSub=fjAllJets.subJetBegin(iFat);iSub<fjAllJets.subJetEnd(iFat);iSub++) {
+	fastjet::PseudoJet subJet = storeFourVectors_ ?
+	  fourVectorJet(fjAllJets.subJetP4(iSub)) : fjAllJets.subJet(iSub);
+	constituents.assign(fjAllJets.constituents(iSub),
+			    fjAllJets.constituents(iSub)+fjAllJets.nConstituents(iSub));
+	subJets.push_back(CompoundPseudoSubJet(scale*subJet,
+					       fjAllJets.subJetArea(iSub),
+					       constituents));
+      }
+      fjJets[iScale].push_back(CompoundPseudoJet(scale*hardJet,
+						 fjAllJets.hardJetArea(iFat),
+						 subJets));
+    }
+  }
+}
+
+
+//______________________________________________________________________________
+boost::shared_ptr<fastjet::ClusterSequence>
+SubjetFilterAlgorithm::cluster(const std::vector<fastjet::PseudoJet>& fjInputs,
+			       ClusterSequenceCache* cache) const
+{
+  if (0!=ghostPool_.get())
+    return (0!=cache) ?
+      cache->get(fjInputs,*fjJetDef_,*ghostPool_) :
+      ghostPool_->cluster(fjInputs,*fjJetDef_,ghostPool_->select(fjInputs));
+  return (0!=cache) ?
+    cache->get(fjInputs,*fjJetDef_,fjAreaDef_.get()) :
+    ClusterSequenceCache::cluster(fjInputs,*fjJetDef_,fjAreaDef_.get());
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::filterJets(const fastjet::ClusterSequence& cs,
+				       double jetPtMin,
+				       CompoundPseudoJetCollection& fjJets) const
+{
+  vector<Parameters> parameters(1,Parameters(massDropCut_,std::sqrt(asymmCut2_),
+					     asymmCutLater_,rFilt_));
+  vector<CompoundPseudoJetCollection*> fjJetsPtrs(1,&fjJets);
+  filterJets(cs,jetPtMin,parameters,fjJetsPtrs);
+}
+
+
+//______________________________________________________________________________
+void SubjetFilterAlgorithm::filterJets(const fastjet::ClusterSequence& cs,
+				       double jetPtMin,
+				       const vector<Parameters>& parameters,
+				       const vector<CompoundPseudoJetCollection*>& fjJets) const
+{
+  const fastjet::ClusterSequenceAreaBase* csArea = (areaConfig_.hasArea()) ?
+    dynamic_cast<const fastjet::ClusterSequenceAreaBase*>(&cs) : 0;
   
   vector<fastjet::PseudoJet> fjFatJets =
-    fastjet::sorted_by_pt(cs->inclusive_jets(jetPtMin_));
+    fastjet::sorted_by_pt(cs.inclusive_jets(jetPtMin));
+  
+  JetSplittingRecord record;
+  vector<int>        massDropNodes;
+  vector<double>     nodeAreas;
+  vector<int>        filterNodes;
+  vector<int>        subJetNodes;
+  vector<int>        constituents;
   
   size_t nFat =
     (nFatMax_==0) ? fjFatJets.size() : std::min(fjFatJets.size(),(size_t)nFatMax_);
+  size_t nArea =
+    (nAreaJets_==0) ? nFat : std::min(nFat,(size_t)nAreaJets_);
   
   for (size_t iFat=0;iFat<nFat;iFat++) {
     
     if (verbose_) cout<<endl<<iFat<<". FATJET: "<<fjFatJets[iFat]<<endl;
     
     fastjet::PseudoJet fjFatJet = fjFatJets[iFat];
-    fastjet::PseudoJet fjCurrentJet(fjFatJet);
-    fastjet::PseudoJet fjSubJet1,fjSubJet2;
-    bool hadSubJets;
+    record.reset(cs,fjFatJet);
+    bool withArea = (iFat<nArea);
     
-    vector<CompoundPseudoSubJet> subJets;
+    // areas are shared by all parameter sets, compute each one once
+    nodeAreas.assign(record.size(),-1.0);
     
+    // the mass-drop declustering always follows the heavier parent, so all
+    // parameter sets stop somewhere along the same path: walk it once
+    massDropNodes.clear();
+    for (int i=record.root();record.hasParents(i);) {
+      massDropNodes.push_back(i);
+      int iSub1 = record[i].parent1;
+      int iSub2 = record[i].parent2;
+      i = (record[iSub1].m < record[iSub2].m) ? iSub2 : iSub1;
+    }
     
-    // FIND SUBJETS PASSING MASSDROP [AND ASYMMETRY] CUT(S)
-    while ((hadSubJets = cs->has_parents(fjCurrentJet,fjSubJet1,fjSubJet2))) {
+    for (size_t iPar=0;iPar<parameters.size();iPar++) {
       
-      if (fjSubJet1.m() < fjSubJet2.m()) swap(fjSubJet1,fjSubJet2);
+      const Parameters&            par       = parameters[iPar];
+      CompoundPseudoJetCollection& jets      = *fjJets[iPar];
+      double                       asymmCut2 = par.asymmCut*par.asymmCut;
       
-      if (verbose_) cout<<"SUBJET CANDIDATES: "<<fjSubJet1<<endl
-			<<"                   "<<fjSubJet2<<endl;
-      if (verbose_) cout<<"md="<<fjSubJet1.m()/fjCurrentJet.m()
-			<<" y="<<fjSubJet1.kt_distance(fjSubJet2)/fjCurrentJet.m2()
-			<<endl;
+      // lazy areas are only recorded against the sequence filtered here: a
+      // collection holding another sequence (reused, or shared with another
+      // algorithm) gets its areas now
+      bool lazyAreas = areaConfig_.hasArea()&&lazyAreas_&&jets.areaSequence()==&cs;
       
-      if (fjSubJet1.m()<massDropCut_*fjCurrentJet.m() &&
-	  (asymmCutLater_||
-	   fjSubJet1.kt_distance(fjSubJet2)>asymmCut2_*fjCurrentJet.m2())) {
-	break;
-      }
-      else {
-	fjCurrentJet = fjSubJet1;
+      if (lazyAreas&&withArea) jets.addJetLazyArea(fjFatJet);
+      else jets.addJet(fjFatJet,(withArea) ? nodeArea(record,csArea,nodeAreas,record.root()) : 0.0);
+      
+      
+      // FIND SUBJETS PASSING MASSDROP [AND ASYMMETRY] CUT(S)
+      int iCurrent(-1),iSub1(-1),iSub2(-1);
+      for (size_t k=0;k<massDropNodes.size();k++) {
+	
+	const JetSplittingRecord::Node& current = record[massDropNodes[k]];
+	iSub1 = current.parent1;
+	iSub2 = current.parent2;
+	if (record[iSub1].m < record[iSub2].m) swap(iSub1,iSub2);
+	
+	if (verbose_) cout<<"SUBJET CANDIDATES: "<<record.pseudoJet(iSub1)<<endl
+			  <<"                   "<<record.pseudoJet(iSub2)<<endl;
+	if (verbose_) cout<<"md="<<record[iSub1].m/current.m
+			  <<" y="<<current.kt2/current.m2
+			  <<endl;
+	
+	if (record[iSub1].m<par.massDropCut*current.m &&
+	    (par.asymmCutLater||current.kt2>asymmCut2*current.m2)) {
+	  iCurrent = massDropNodes[k];
+	  break;
+	}
       }
-    }
-    
-    if (!hadSubJets) {
-      if (verbose_) cout<<"FAILED TO SELECT SUBJETS"<<endl;
-    }
-    // FOUND TWO GOOD SUBJETS PASSING MASSDROP CUT
-    else {
-      if (verbose_) cout<<"SUBJETS selected"<<endl;
       
-      if (asymmCutLater_&&
-	  fjSubJet1.kt_distance(fjSubJet2)<=asymmCut2_*fjCurrentJet.m2()) {
-	if (verbose_) cout<<"FAILED y-cut"<<endl;
+      if (iCurrent<0) {
+	if (verbose_) cout<<"FAILED TO SELECT SUBJETS"<<endl;
       }
-      // PASSED ASYMMETRY (Y) CUT
+      // FOUND TWO GOOD SUBJETS PASSING MASSDROP CUT
       else {
-	if (verbose_) cout<<"PASSED y cut"<<endl;
+	if (verbose_) cout<<"SUBJETS selected"<<endl;
 	
-	vector<fastjet::PseudoJet> fjFilterJets;
-	double       Rbb   = std::sqrt(fjSubJet1.squared_distance(fjSubJet2));
-	double       Rfilt = std::min(0.5*Rbb,rFilt_);
-	double       dcut  = Rfilt*Rfilt/rParam_/rParam_;
-	fjFilterJets=fastjet::sorted_by_pt(cs->exclusive_subjets(fjCurrentJet,dcut));
+	const JetSplittingRecord::Node& current = record[iCurrent];
 	
-	if (verbose_) {
-	  cout<<"Rbb="<<Rbb<<", Rfilt="<<Rfilt<<endl;
-	  cout<<"FILTER JETS: "<<flush;
-	  for (size_t i=0;i<fjFilterJets.size();i++) {
-	    if (i>0) cout<<"             "<<flush; cout<<fjFilterJets[i]<<endl;
-	  }
+	if (par.asymmCutLater&&current.kt2<=asymmCut2*current.m2) {
+	  if (verbose_) cout<<"FAILED y-cut"<<endl;
 	}
-	
-	vector<fastjet::PseudoJet> fjSubJets;
-	fjSubJets.push_back(fjSubJet1);
-	fjSubJets.push_back(fjSubJet2);
-	size_t nFilter = fjFilterJets.size();
-	for (size_t iFilter=0;iFilter<nFilter;iFilter++)
-	  fjSubJets.push_back(fjFilterJets[iFilter]);
-	
-	for (size_t iSub=0;iSub<fjSubJets.size();iSub++) {
-	  vector<fastjet::PseudoJet> fjConstituents=
-	    cs->constituents(fjSubJets[iSub]);
-	  vector<int> constituents;
-	  for (size_t iConst=0;iConst<fjConstituents.size();iConst++) {
-	    int userIndex = fjConstituents[iConst].user_index();
-	    if (userIndex>=0)  constituents.push_back(userIndex);
+	// PASSED ASYMMETRY (Y) CUT
+	else {
+	  if (verbose_) cout<<"PASSED y cut"<<endl;
+	  
+	  double       Rbb   = record.deltaR(iCurrent);
+	  double       Rfilt = std::min(0.5*Rbb,par.rFilt);
+	  double       dcut  = Rfilt*Rfilt/rParam_/rParam_;
+	  record.exclusiveSubjets(iCurrent,dcut,filterNodes);
+	  sort(filterNodes.begin(),filterNodes.end(),NodePtGreater(record));
+	  
+	  if (verbose_) {
+	    cout<<"Rbb="<<Rbb<<", Rfilt="<<Rfilt<<endl;
+	    cout<<"FILTER JETS: "<<flush;
+	    for (size_t i=0;i<filterNodes.size();i++) {
+	      if (i>0) cout<<"             "<<flush;
+	      cout<<record.pseudoJet(filterNodes[i])<<endl;
+	    }
 	  }
-
-	  double subJetArea=(doAreaFastjet_) ?
-	    ((fastjet::ClusterSequenceArea*)cs)->area(fjSubJets[iSub]) : 0.0;
 	  
-	  if (iSub<2||constituents.size()>0)
-	    subJets.push_back(CompoundPseudoSubJet(fjSubJets[iSub],
-						   subJetArea,
-						   constituents));
-	}
+	  subJetNodes.clear();
+	  subJetNodes.push_back(iSub1);
+	  subJetNodes.push_back(iSub2);
+	  subJetNodes.insert(subJetNodes.end(),filterNodes.begin(),filterNodes.end());
+	  
+	  for (size_t iSub=0;iSub<subJetNodes.size();iSub++) {
+	    int iNode = subJetNodes[iSub];
+	    const fastjet::PseudoJet& fjSubJet = record.pseudoJet(iNode);
+	    if (lazyAreas&&withArea) jets.addSubJetLazyArea(fjSubJet);
+	    else jets.addSubJet(fjSubJet,(withArea) ? nodeArea(record,csArea,nodeAreas,iNode) : 0.0);
+	    
+	    record.constituents(iNode,constituents);
+	    jets.addConstituents(constituents);
+	    
+	    unsigned iLast = jets.nSubJets()-1;
+	    if (iSub>=2&&jets.nConstituents(iLast)==0) jets.popSubJet();
+	  }
+	  
+	} // PASSED Y CUT
 	
-      } // PASSED Y CUT
+      } // PASSED MASSDROP CUT
       
-    } // PASSED MASSDROP CUT
-    
-    if (verbose_) cout<<"write fatjet with "<<subJets.size()<<" sub+filter jets"
-		      <<endl;
-    
-    double fatJetArea = (doAreaFastjet_) ?
-      ((fastjet::ClusterSequenceArea*)cs)->area(fjFatJet) : 0.0;
-
-    fjJets.push_back(CompoundPseudoJet(fjFatJet,fatJetArea,subJets));
-    
-    ntotal_++;
-    if (subJets.size()>3) nfound_++;
+      if (verbose_) cout<<"write fatjet with "<<jets.nSubJets(jets.size()-1)
+			<<" sub+filter jets"<<endl;
+      
+    } // LOOP OVER PARAMETER SETS
     
   } // LOOP OVER FATJETS
-  
-  if (verbose_) cout<<endl<<fjJets.size()<<" FATJETS written\n"<<endl;
-  
-  delete cs;
-  
-  return;
+}
+
+
+//______________________________________________________________________________
+double SubjetFilterAlgorithm::nodeArea(const JetSplittingRecord& record,
+				       const fastjet::ClusterSequenceAreaBase* csArea,
+				       vector<double>& nodeAreas,int i)
+{
+  if (nodeAreas[i]<0.0)
+    nodeAreas[i] = (0!=csArea) ? csArea->area(record.pseudoJet(i)) : 0.0;
+  return nodeAreas[i];
 }
 
 
 //______________________________________________________________________________
 string SubjetFilterAlgorithm::summary() const
 {
-  double eff = (ntotal_>0) ? nfound_/(double)ntotal_ : 0;
+  unsigned long nevents = nevents_;
+  unsigned long ntotal  = ntotal_;
+  unsigned long nfound  = nfound_;
+  double tCluster = clusteringTimeNs_*1e-9;
+  double tFilter  = filteringTimeNs_*1e-9;
+  double tTotal   = tCluster+tFilter;
+  double eff = (ntotal>0) ? nfound/(double)ntotal : 0;
   std::stringstream ss;
   ss<<"************************************************************\n"
     <<"* "<<moduleLabel_<<" (SubjetFilterAlgorithm) SUMMARY:\n"
     <<"************************************************************\n"
-    <<"nevents = "<<nevents_<<endl
-    <<"ntotal  = "<<ntotal_<<endl
-    <<"nfound  = "<<nfound_<<endl
+    <<"nevents = "<<nevents<<endl
+    <<"ntotal  = "<<ntotal<<endl
+    <<"nfound  = "<<nfound<<endl
     <<"eff     = "<<eff<<endl
+    <<"t(clustering) = "<<tCluster<<" s"<<endl
+    <<"t(filtering)  = "<<tFilter<<" s"<<endl
+    <<"events/s      = "<<((tTotal>0.0) ? nevents/tTotal : 0.0)<<endl
+    <<"fatjets/s     = "<<((tTotal>0.0) ? ntotal/tTotal  : 0.0)<<endl
     <<"************************************************************\n";
   return ss.str();
 }
 
 
+//______________________________________________________________________________
+unsigned long long SubjetFilterAlgorithm::nanoseconds(const tbb::tick_count::interval_t& dt)
+{
+  return static_cast<unsigned long long>(dt.seconds()*1e9);
+}
+
+
 
 /// does the actual work for printing out a jet
-ostream & operator<<(ostream & ostr, fastjet::PseudoJet & jet) {
+ostream & operator<<(ostream & ostr, const fastjet::PseudoJet & jet) {
   ostr << "pt="  <<setw(10)<<jet.perp() 
        << " eta="<<setw(6) <<jet.eta()  
        << " m="  <<setw(10)<<jet.m();
@@ -0,0 +1,162 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// benchmarkJetAreaModes
+// ---------------------
+//
+// cost of each JetAreaConfig mode: SubjetFilterAlgorithm::run() and
+// CATopJetAlgorithm::cluster() + run() on the same random events (soft
+// background plus two boosted three-prong jets), clustered with each of the
+// five area modes. The time per event is printed for every mode, together
+// with the number of fat jets found, which does not depend on the mode.
+//
+// usage: benchmarkJetAreaModes [nEvents]
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/JetAreaConfig.h"
+#include "RecoJets/JetAlgorithms/interface/SubjetFilterAlgorithm.h"
+#include "RecoJets/JetAlgorithms/interface/CATopJetAlgorithm.h"
+#include "RecoJets/JetAlgorithms/interface/CompoundPseudoJetCollection.h"
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include "tbb/tick_count.h"
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+
+
+using namespace std;
+
+
+namespace {
+
+  const unsigned nEventsDefault = 10;
+
+  /// minimal LCG, so that the events do not depend on the platform's rand()
+  class Random
+  {
+  public:
+    Random(unsigned long seed) : state_(seed) {}
+    double flat() {
+      state_ = (6364136223846793005ULL*state_+1442695040888963407ULL);
+      return (state_>>11)*(1.0/9007199254740992.0);
+    }
+  private:
+    unsigned long long state_;
+  };
+
+  void addParticle(double pt,double y,double phi,
+		   vector<fastjet::PseudoJet>& particles)
+  {
+    particles.push_back(fastjet::PseudoJet(pt*cos(phi),pt*sin(phi),
+					   pt*sinh(y),pt*cosh(y)));
+    particles.back().set_user_index(particles.size()-1);
+  }
+
+  /// 400 soft particles in |y|<2.5, and two back-to-back jets of three
+  /// prongs of 15 particles each
+  void generateEvent(Random& random,vector<fastjet::PseudoJet>& particles)
+  {
+    particles.clear();
+    for (unsigned i=0;i<400;i++)
+      addParticle(0.5+2.5*random.flat(),-2.5+5.0*random.flat(),
+		  2.0*M_PI*random.flat(),particles);
+    double phiJet = 2.0*M_PI*random.flat();
+    for (unsigned iJet=0;iJet<2;iJet++) {
+      double yJet = -1.5+3.0*random.flat();
+      phiJet += M_PI;
+      for (unsigned iProng=0;iProng<3;iProng++) {
+	double yProng   = yJet  +0.6*(random.flat()-0.5);
+	double phiProng = phiJet+0.6*(random.flat()-0.5);
+	for (unsigned i=0;i<15;i++)
+	  addParticle(2.0+20.0*random.flat(),
+		      yProng  +0.1*(random.flat()-0.5),
+		      phiProng+0.1*(random.flat()-0.5),particles);
+      }
+    }
+  }
+
+  double milliseconds(const tbb::tick_count::interval_t& dt)
+  {
+    return dt.seconds()*1e3;
+  }
+
+}
+
+
+//______________________________________________________________________________
+int main(int argc,char** argv)
+{
+  unsigned nEvents = (argc>1) ? atoi(argv[1]) : nEventsDefault;
+
+  vector<vector<fastjet::PseudoJet> > events(nEvents);
+  Random random(13);
+  for (unsigned iEvent=0;iEvent<nEvents;iEvent++) generateEvent(random,events[iEvent]);
+
+  static const JetAreaConfig::Mode modes[] = {
+    JetAreaConfig::NoArea,
+    JetAreaConfig::Voronoi,
+    JetAreaConfig::Passive,
+    JetAreaConfig::Active,
+    JetAreaConfig::ActiveExplicitGhosts
+  };
+
+  // CATopJetAlgorithm, with the parameters of the CMS top tagger
+  vector<double> sumEtBins(3),rBins(3,0.8),ptFracBins(3,0.05),deltarBins(3,0.19),nCellBins(3,1.9);
+  sumEtBins[0] = 0.0; sumEtBins[1] = 1600.0; sumEtBins[2] = 2600.0;
+
+  cout<<"area mode             SubjetFilter [ms/event] (fat jets)"
+      <<"   CATop [ms/event] (hard jets)"<<endl;
+  for (unsigned iMode=0;iMode<sizeof(modes)/sizeof(JetAreaConfig::Mode);iMode++) {
+    JetAreaConfig areaConfig(modes[iMode]);
+
+    SubjetFilterAlgorithm subjetFilter("benchmark","ca",2,1.2,0.3,100.0,
+				       0.67,0.3,false,false,
+				       areaConfig.ghostEtaMax,
+				       areaConfig.activeAreaRepeats,
+				       areaConfig.ghostArea,false);
+    subjetFilter.setAreaConfig(areaConfig);
+
+    CATopJetAlgorithm caTop(edm::InputTag("benchmark"),false,1,2,2.5,100.0,
+			    sumEtBins,rBins,ptFracBins,deltarBins,nCellBins,
+			    1.0,false,2.5,0.7);
+    caTop.setAreaConfig(areaConfig);
+
+    unsigned nFatJets(0),nHardJets(0);
+    CompoundPseudoJetCollection fatJets;
+    vector<fastjet::PseudoJet>  hardJets;
+
+    tbb::tick_count t0 = tbb::tick_count::now();
+    for (unsigned iEvent=0;iEvent<nEvents;iEvent++) {
+      boost::shared_ptr<fastjet::ClusterSequence> fjClusterSeq;
+      fatJets.clear();
+      subjetFilter.run(events[iEvent],fatJets,fjClusterSeq);
+      nFatJets += fatJets.size();
+    }
+    tbb::tick_count t1 = tbb::tick_count::now();
+    for (unsigned iEvent=0;iEvent<nEvents;iEvent++) {
+      boost::shared_ptr<fastjet::ClusterSequence> fjClusterSeq =
+	caTop.cluster(events[iEvent]);
+      hardJets.clear();
+      caTop.run(events[iEvent],hardJets,fjClusterSeq);
+      nHardJets += hardJets.size();
+    }
+    tbb::tick_count t2 = tbb::tick_count::now();
+
+    cout<<setw(22)<<left<<JetAreaConfig::modeName(modes[iMode])<<right
+	<<setw(10)<<setprecision(4)<<milliseconds(t1-t0)/nEvents
+	<<setw(16)<<nFatJets
+	<<setw(20)<<setprecision(4)<<milliseconds(t2-t1)/nEvents
+	<<setw(14)<<nHardJets<<endl;
+  }
+
+  return 0;
+}
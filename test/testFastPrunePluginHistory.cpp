@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// testFastPrunePluginHistory
+// --------------------------
+//
+// differential test of FastPrunePlugin's history pruning against the
+// reclustering it replaces, on random multi-prong events:
+//   - without pruning (zcut=0) both modes must give identical histories,
+//     dij included, and identical jets;
+//   - at the nominal cuts (zcut=0.1, Rcut_factor=0.5) the jets may differ
+//     where a pruned merging reorders the later C/A mergings (see
+//     FastPrunePlugin::set_history_pruning()); the fraction of differing
+//     jets is printed and must stay below maxJetDiffFraction.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/FastPrunePlugin.hh"
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+
+using namespace std;
+
+
+namespace {
+
+  const unsigned nEvents            = 1000;
+  const double   maxJetDiffFraction = 0.02;
+  const double   tolerance          = 1e-10;
+
+  /// minimal LCG, so that the events do not depend on the platform's rand()
+  class Random
+  {
+  public:
+    Random(unsigned long seed) : state_(seed) {}
+    double flat() {
+      state_ = (6364136223846793005ULL*state_+1442695040888963407ULL);
+      return (state_>>11)*(1.0/9007199254740992.0);
+    }
+  private:
+    unsigned long long state_;
+  };
+
+  /// nParticles particles in four prongs with a steeply falling pt spectrum
+  void generateEvent(Random& random,unsigned nParticles,
+		     vector<fastjet::PseudoJet>& particles)
+  {
+    static const double y0[]   = { 0.0, 1.5,-1.0, 0.5 };
+    static const double phi0[] = { 0.0, 2.0, 4.0, 5.5 };
+    particles.clear();
+    for (unsigned i=0;i<nParticles;i++) {
+      unsigned prong = std::min(3u,unsigned(4*random.flat()));
+      double pt  = 0.5+60.0*pow(random.flat(),3);
+      double y   = y0[prong]  +0.9*(random.flat()-0.5);
+      double phi = phi0[prong]+0.9*(random.flat()-0.5);
+      particles.push_back(fastjet::PseudoJet(pt*cos(phi),pt*sin(phi),
+					     pt*sinh(y),pt*cosh(y)));
+    }
+  }
+
+  bool sameValue(double a,double b)
+  {
+    return fabs(a-b)<=tolerance*std::max(1.0,std::max(fabs(a),fabs(b)));
+  }
+
+  /// identical mergings: parents and dij of every history element
+  bool sameHistory(const fastjet::ClusterSequence& a,
+		   const fastjet::ClusterSequence& b)
+  {
+    const vector<fastjet::ClusterSequence::history_element>& ha = a.history();
+    const vector<fastjet::ClusterSequence::history_element>& hb = b.history();
+    if (ha.size()!=hb.size()) return false;
+    for (unsigned i=0;i<ha.size();i++)
+      if (ha[i].parent1!=hb[i].parent1||ha[i].parent2!=hb[i].parent2||
+	  !sameValue(ha[i].dij,hb[i].dij)) return false;
+    return true;
+  }
+
+  /// identical pruned jets: momentum, constituents, unpruned jet and the
+  /// pts of the pruned branches
+  bool sameJet(const fastjet::ClusterSequence& a,const fastjet::PseudoJet& ja,
+	       const fastjet::ClusterSequence& b,const fastjet::PseudoJet& jb)
+  {
+    if (!sameValue(ja.px(),jb.px())||!sameValue(ja.py(),jb.py())||
+	!sameValue(ja.pz(),jb.pz())||!sameValue(ja.E(),jb.E())) return false;
+
+    vector<int> ca,cb;
+    vector<fastjet::PseudoJet> constituents = a.constituents(ja);
+    for (unsigned i=0;i<constituents.size();i++)
+      ca.push_back(constituents[i].cluster_hist_index());
+    constituents = b.constituents(jb);
+    for (unsigned i=0;i<constituents.size();i++)
+      cb.push_back(constituents[i].cluster_hist_index());
+    sort(ca.begin(),ca.end());
+    sort(cb.begin(),cb.end());
+    if (ca!=cb) return false;
+
+    typedef fastjet::FastPrunePlugin::Extras Extras;
+    const Extras* ea = dynamic_cast<const Extras*>(a.extras());
+    const Extras* eb = dynamic_cast<const Extras*>(b.extras());
+    int ua = ea->unpruned_jet_index(a,ja);
+    int ub = eb->unpruned_jet_index(b,jb);
+    if (ua!=ub) return false;
+    if (ua<0) return true;
+
+    vector<double> pa,pb;
+    for (Extras::branch_iterator it=ea->pruned_branches_begin(ua);
+	 it!=ea->pruned_branches_end(ua);++it)
+      pa.push_back(Extras::pruned_branch(a,*it).perp());
+    for (Extras::branch_iterator it=eb->pruned_branches_begin(ub);
+	 it!=eb->pruned_branches_end(ub);++it)
+      pb.push_back(Extras::pruned_branch(b,*it).perp());
+    if (pa.size()!=pb.size()) return false;
+    sort(pa.begin(),pa.end());
+    sort(pb.begin(),pb.end());
+    for (unsigned i=0;i<pa.size();i++) if (!sameValue(pa[i],pb[i])) return false;
+    return true;
+  }
+
+  struct Comparison
+  {
+    Comparison() : nJets(0), nJetsDiffering(0), nHistoriesDiffering(0) {}
+    unsigned nJets;
+    unsigned nJetsDiffering;
+    unsigned nHistoriesDiffering;
+  };
+
+  /// cluster the same events with reclustering and with history pruning
+  Comparison compare(double rParam,double zcut,double rcutFactor)
+  {
+    fastjet::JetDefinition findDef(fastjet::cambridge_algorithm,rParam);
+    fastjet::JetDefinition pruneDef(fastjet::cambridge_algorithm,0.5*M_PI);
+    fastjet::FastPrunePlugin recluster(findDef,pruneDef,zcut,rcutFactor);
+    fastjet::FastPrunePlugin history(findDef,pruneDef,zcut,rcutFactor);
+    recluster.set_unpruned_minpT(10.0);
+    history.set_unpruned_minpT(10.0);
+    history.set_history_pruning(true);
+    fastjet::JetDefinition reclusterDef(&recluster);
+    fastjet::JetDefinition historyDef(&history);
+
+    Comparison result;
+    Random random(9);
+    vector<fastjet::PseudoJet> particles;
+    for (unsigned iEvent=0;iEvent<nEvents;iEvent++) {
+      generateEvent(random,20+unsigned(120*random.flat()),particles);
+      fastjet::ClusterSequence csRecluster(particles,reclusterDef);
+      fastjet::ClusterSequence csHistory(particles,historyDef);
+      if (!sameHistory(csRecluster,csHistory)) result.nHistoriesDiffering++;
+
+      vector<fastjet::PseudoJet> jetsRecluster =
+	fastjet::sorted_by_pt(csRecluster.inclusive_jets());
+      vector<fastjet::PseudoJet> jetsHistory =
+	fastjet::sorted_by_pt(csHistory.inclusive_jets());
+      unsigned nJets = std::max(jetsRecluster.size(),jetsHistory.size());
+      unsigned nCommon = std::min(jetsRecluster.size(),jetsHistory.size());
+      result.nJets          += nJets;
+      result.nJetsDiffering += nJets-nCommon;
+      for (unsigned i=0;i<nCommon;i++)
+	if (!sameJet(csRecluster,jetsRecluster[i],csHistory,jetsHistory[i]))
+	  result.nJetsDiffering++;
+    }
+    return result;
+  }
+
+}
+
+
+//______________________________________________________________________________
+int main()
+{
+  static const double rParams[] = { 0.4, 0.8, 1.2, 1.5 };
+
+  unsigned nFailures(0);
+  for (unsigned iR=0;iR<sizeof(rParams)/sizeof(double);iR++) {
+    double rParam = rParams[iR];
+
+    Comparison unpruned = compare(rParam,0.0,0.5);
+    cout<<"R="<<rParam<<" zcut=0: "<<unpruned.nJets<<" jets, "
+	<<unpruned.nJetsDiffering<<" differing, "
+	<<unpruned.nHistoriesDiffering<<" histories differing"<<endl;
+    if (unpruned.nJetsDiffering!=0||unpruned.nHistoriesDiffering!=0) {
+      cout<<"FAILED: history pruning differs from reclustering at zcut=0"<<endl;
+      nFailures++;
+    }
+
+    Comparison pruned = compare(rParam,0.1,0.5);
+    double fraction = (pruned.nJets>0) ?
+      pruned.nJetsDiffering/double(pruned.nJets) : 0.0;
+    cout<<"R="<<rParam<<" zcut=0.1 Rcut_factor=0.5: "<<pruned.nJets<<" jets, "
+	<<pruned.nJetsDiffering<<" differing ("<<100.0*fraction<<"%), "
+	<<pruned.nHistoriesDiffering<<" histories differing"<<endl;
+    if (fraction>=maxJetDiffFraction) {
+      cout<<"FAILED: more than "<<100.0*maxJetDiffFraction
+	  <<"% of the pruned jets differ"<<endl;
+      nFailures++;
+    }
+  }
+
+  return (nFailures==0) ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+// testMultiRadiusCAJetAlgorithm
+// -----------------------------
+//
+// compares the inclusive jets which MultiRadiusCAJetAlgorithm reads off one
+// C/A clustering with R=1.2 against separate C/A clusterings with R=0.4,
+// 0.8 and 1.2 of the same random events: the jets must have identical
+// four-momenta and constituents.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+
+#include "RecoJets/JetAlgorithms/interface/MultiRadiusCAJetAlgorithm.h"
+
+#include <fastjet/ClusterSequence.hh>
+#include <fastjet/JetDefinition.hh>
+#include <fastjet/PseudoJet.hh>
+
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+
+using namespace std;
+
+
+namespace {
+
+  const unsigned nEvents  = 1000;
+  const double   jetPtMin = 5.0;
+
+  /// minimal LCG, so that the events do not depend on the platform's rand()
+  class Random
+  {
+  public:
+    Random(unsigned long seed) : state_(seed) {}
+    double flat() {
+      state_ = (6364136223846793005ULL*state_+1442695040888963407ULL);
+      return (state_>>11)*(1.0/9007199254740992.0);
+    }
+  private:
+    unsigned long long state_;
+  };
+
+  /// nParticles particles, uniform in rapidity and phi
+  void generateEvent(Random& random,unsigned nParticles,
+		     vector<fastjet::PseudoJet>& particles)
+  {
+    particles.clear();
+    for (unsigned i=0;i<nParticles;i++) {
+      double pt  = 0.5+60.0*pow(random.flat(),3);
+      double y   = -2.5+5.0*random.flat();
+      double phi = 2.0*M_PI*random.flat();
+      particles.push_back(fastjet::PseudoJet(pt*cos(phi),pt*sin(phi),
+					     pt*sinh(y),pt*cosh(y)));
+      particles.back().set_user_index(i);
+    }
+  }
+
+  /// sorted user indices of the constituents of jet
+  void constituentIndices(const fastjet::ClusterSequence& cs,
+			  const fastjet::PseudoJet& jet,
+			  vector<int>& indices)
+  {
+    indices.clear();
+    vector<fastjet::PseudoJet> constituents = cs.constituents(jet);
+    for (unsigned i=0;i<constituents.size();i++)
+      indices.push_back(constituents[i].user_index());
+    sort(indices.begin(),indices.end());
+  }
+
+}
+
+
+//______________________________________________________________________________
+int main()
+{
+  static const double rParams[] = { 0.4, 0.8, 1.2 };
+  const unsigned nR = sizeof(rParams)/sizeof(double);
+
+  MultiRadiusCAJetAlgorithm algorithm(vector<double>(rParams,rParams+nR),jetPtMin);
+
+  vector<unsigned> nJets(nR,0);
+  vector<unsigned> nJetsDiffering(nR,0);
+  Random random(11);
+  vector<fastjet::PseudoJet> particles;
+  vector<vector<fastjet::PseudoJet> > jets;
+  vector<int> indices,refIndices;
+  for (unsigned iEvent=0;iEvent<nEvents;iEvent++) {
+    generateEvent(random,2+unsigned(150*random.flat()),particles);
+    boost::shared_ptr<fastjet::ClusterSequence> cs;
+    algorithm.run(particles,jets,cs);
+
+    for (unsigned iR=0;iR<nR;iR++) {
+      fastjet::JetDefinition jetDef(fastjet::cambridge_algorithm,rParams[iR]);
+      fastjet::ClusterSequence csRef(particles,jetDef);
+      vector<fastjet::PseudoJet> refJets =
+	fastjet::sorted_by_pt(csRef.inclusive_jets(jetPtMin));
+
+      unsigned nCommon = std::min(refJets.size(),jets[iR].size());
+      nJets[iR]          += std::max(refJets.size(),jets[iR].size());
+      nJetsDiffering[iR] += std::max(refJets.size(),jets[iR].size())-nCommon;
+      for (unsigned i=0;i<nCommon;i++) {
+	const fastjet::PseudoJet& jet    = jets[iR][i];
+	const fastjet::PseudoJet& refJet = refJets[i];
+	constituentIndices(*cs,jet,indices);
+	constituentIndices(csRef,refJet,refIndices);
+	if (jet.px()!=refJet.px()||jet.py()!=refJet.py()||
+	    jet.pz()!=refJet.pz()||jet.E()!=refJet.E()||
+	    indices!=refIndices) nJetsDiffering[iR]++;
+      }
+    }
+  }
+
+  unsigned nFailures(0);
+  for (unsigned iR=0;iR<nR;iR++) {
+    cout<<"R="<<rParams[iR]<<": "<<nJets[iR]<<" jets, "
+	<<nJetsDiffering[iR]<<" differing"<<endl;
+    if (nJetsDiffering[iR]!=0) {
+      cout<<"FAILED: jets differ from a separate clustering with R="
+	  <<rParams[iR]<<endl;
+      nFailures++;
+    }
+  }
+
+  return (nFailures==0) ? 0 : 1;
+}